@@ -29,13 +29,25 @@ SOURCES += \
         mainwindow.cpp \
     plotdrawer.cpp \
     dataloader.cpp \
-    renderthread.cpp
+    compressedpoints.cpp \
+    rangestatistics.cpp \
+    renderthread.cpp \
+    interactiontrace.cpp \
+    livebuffer.cpp \
+    livesource.cpp \
+    dataexporter.cpp
 
 HEADERS += \
         mainwindow.h \
     plotdrawer.h \
     dataloader.h \
-    renderthread.h
+    compressedpoints.h \
+    rangestatistics.h \
+    renderthread.h \
+    interactiontrace.h \
+    livebuffer.h \
+    livesource.h \
+    dataexporter.h
 
 FORMS += \
         mainwindow.ui
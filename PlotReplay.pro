@@ -0,0 +1,33 @@
+#-------------------------------------------------
+#
+# Headless replay of PlotDrawer interaction traces
+#
+#-------------------------------------------------
+
+QT       += core gui concurrent
+
+TARGET = PlotReplay
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+CONFIG += c++14
+
+SOURCES += \
+    plotreplay.cpp \
+    dataloader.cpp \
+    compressedpoints.cpp \
+    rangestatistics.cpp \
+    renderthread.cpp \
+    interactiontrace.cpp \
+    livebuffer.cpp
+
+HEADERS += \
+    dataloader.h \
+    compressedpoints.h \
+    rangestatistics.h \
+    renderthread.h \
+    interactiontrace.h \
+    livebuffer.h
@@ -0,0 +1,274 @@
+#include "compressedpoints.h"
+
+#include "dataloader.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace DataLoader {
+
+// Определение нужно до C++17: BlockSize передается по ссылке в std::min
+const size_t CompressedPoints::BlockSize;
+
+namespace {
+
+uint64_t toBits(double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double fromBits(uint64_t bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+uint64_t zigZag(uint64_t value)
+{
+    return (value << 1) ^ (0 - (value >> 63));
+}
+
+uint64_t unZigZag(uint64_t value)
+{
+    return (value >> 1) ^ (0 - (value & 1));
+}
+
+int leadingZeros(uint64_t value)
+{
+    return __builtin_clzll(value);
+}
+
+int trailingZeros(uint64_t value)
+{
+    return __builtin_ctzll(value);
+}
+
+}
+
+class CompressedPoints::BitWriter
+{
+public:
+    BitWriter(std::vector<uint64_t> &stream, uint64_t position) : stream(stream), bits(position) {}
+
+    uint64_t position() const { return bits; }
+
+    void write(uint64_t value, int length)
+    {
+        if (length == 0)
+            return;
+        if (length < 64)
+            value &= (uint64_t(1) << length) - 1;
+
+        const int used = static_cast<int>(bits % 64);
+        if (used == 0)
+            stream.push_back(0);
+
+        const int free = 64 - used;
+        if (length <= free) {
+            stream.back() |= value << (free - length);
+        } else {
+            stream.back() |= value >> (length - free);
+            stream.push_back(value << (64 - (length - free)));
+        }
+        bits += static_cast<uint64_t>(length);
+    }
+
+private:
+    std::vector<uint64_t> &stream;
+    uint64_t bits;
+};
+
+class CompressedPoints::BitReader
+{
+public:
+    BitReader(const std::vector<uint64_t> &stream, uint64_t position) : stream(stream), bits(position) {}
+
+    uint64_t read(int length)
+    {
+        if (length == 0)
+            return 0;
+
+        const size_t word = static_cast<size_t>(bits / 64);
+        const int used = static_cast<int>(bits % 64);
+        const int free = 64 - used;
+        uint64_t value;
+        if (length <= free) {
+            value = stream[word] >> (free - length);
+        } else {
+            value = (stream[word] << (length - free)) | (stream[word+1] >> (64 - (length - free)));
+        }
+        bits += static_cast<uint64_t>(length);
+
+        return length < 64 ? value & ((uint64_t(1) << length) - 1) : value;
+    }
+
+    bool readBit() { return read(1) != 0; }
+
+private:
+    const std::vector<uint64_t> &stream;
+    uint64_t bits;
+};
+
+CompressedPoints::CompressedPoints(const std::vector<Point> &points)
+{
+    append(points.data(), points.size());
+    shrinkToFit();
+}
+
+// Добавляет точки новыми блоками, поэтому все части, кроме последней, должны быть кратны BlockSize
+void CompressedPoints::append(const Point *points, size_t pointsQuan)
+{
+    BitWriter timestampsWriter(timestampsStream, timestampsBits);
+    BitWriter valuesWriter(valuesStream, valuesBits);
+
+    for (size_t start = 0; start < pointsQuan; start += BlockSize) {
+        const size_t end = std::min(start + BlockSize, pointsQuan);
+        Block block = {timestampsWriter.position(), valuesWriter.position(), points[start].value, points[start].value};
+
+        // Метки времени: первая и первая разность целиком, далее delta-of-delta в zigzag-коде
+        uint64_t prevTimestamp = toBits(points[start].timestamp);
+        uint64_t prevDelta = 0;
+        timestampsWriter.write(prevTimestamp, 64);
+        for (size_t i = start + 1; i < end; ++i) {
+            const uint64_t timestamp = toBits(points[i].timestamp);
+            const uint64_t delta = timestamp - prevTimestamp;
+            if (i == start + 1) {
+                timestampsWriter.write(delta, 64);
+            } else {
+                const uint64_t dod = zigZag(delta - prevDelta);
+                if (dod == 0) {
+                    timestampsWriter.write(0b0, 1);
+                } else if (dod < (1u << 7)) {
+                    timestampsWriter.write(0b10, 2);
+                    timestampsWriter.write(dod, 7);
+                } else if (dod < (1u << 9)) {
+                    timestampsWriter.write(0b110, 3);
+                    timestampsWriter.write(dod, 9);
+                } else if (dod < (1u << 12)) {
+                    timestampsWriter.write(0b1110, 4);
+                    timestampsWriter.write(dod, 12);
+                } else {
+                    timestampsWriter.write(0b1111, 4);
+                    timestampsWriter.write(dod, 64);
+                }
+            }
+            prevTimestamp = timestamp;
+            prevDelta = delta;
+        }
+
+        // Значения: первое целиком, далее XOR с предыдущим; значащие биты записываются в окне
+        // предыдущего значения, если помещаются в него
+        uint64_t prevValue = toBits(points[start].value);
+        int prevLeading = 65, prevTrailing = 0;
+        valuesWriter.write(prevValue, 64);
+        for (size_t i = start + 1; i < end; ++i) {
+            block.min = std::min(block.min, points[i].value);
+            block.max = std::max(block.max, points[i].value);
+
+            const uint64_t value = toBits(points[i].value);
+            const uint64_t xorValue = value ^ prevValue;
+            prevValue = value;
+            if (xorValue == 0) {
+                valuesWriter.write(0b0, 1);
+                continue;
+            }
+
+            const int leading = std::min(leadingZeros(xorValue), 31);
+            const int trailing = trailingZeros(xorValue);
+            if (leading >= prevLeading && trailing >= prevTrailing) {
+                valuesWriter.write(0b10, 2);
+                valuesWriter.write(xorValue >> prevTrailing, 64 - prevLeading - prevTrailing);
+            } else {
+                const int meaningful = 64 - leading - trailing;
+                valuesWriter.write(0b11, 2);
+                valuesWriter.write(static_cast<uint64_t>(leading), 5);
+                valuesWriter.write(static_cast<uint64_t>(meaningful - 1), 6);
+                valuesWriter.write(xorValue >> trailing, meaningful);
+                prevLeading = leading;
+                prevTrailing = trailing;
+            }
+        }
+
+        blocks.push_back(block);
+    }
+
+    timestampsBits = timestampsWriter.position();
+    valuesBits = valuesWriter.position();
+    quan += pointsQuan;
+}
+
+void CompressedPoints::shrinkToFit()
+{
+    timestampsStream.shrink_to_fit();
+    valuesStream.shrink_to_fit();
+    blocks.shrink_to_fit();
+}
+
+size_t CompressedPoints::memoryUsage() const
+{
+    return sizeof(*this) + (timestampsStream.capacity() + valuesStream.capacity()) * sizeof(uint64_t)
+            + blocks.capacity() * sizeof(Block);
+}
+
+size_t CompressedPoints::blockLength(size_t index) const
+{
+    return std::min(BlockSize, quan - index * BlockSize);
+}
+
+void CompressedPoints::decodeValues(size_t index, double *values) const
+{
+    BitReader reader(valuesStream, blocks[index].valuesBit);
+    const size_t length = blockLength(index);
+
+    uint64_t value = reader.read(64);
+    values[0] = fromBits(value);
+
+    int leading = 0, trailing = 0;
+    for (size_t i = 1; i < length; ++i) {
+        if (reader.readBit()) {
+            if (reader.readBit()) {
+                leading = static_cast<int>(reader.read(5));
+                trailing = 64 - leading - static_cast<int>(reader.read(6)) - 1;
+            }
+            value ^= reader.read(64 - leading - trailing) << trailing;
+        }
+        values[i] = fromBits(value);
+    }
+}
+
+void CompressedPoints::decodeTimestamps(size_t index, double *timestamps) const
+{
+    BitReader reader(timestampsStream, blocks[index].timestampsBit);
+    const size_t length = blockLength(index);
+
+    uint64_t timestamp = reader.read(64);
+    timestamps[0] = fromBits(timestamp);
+    if (length == 1)
+        return;
+
+    uint64_t delta = reader.read(64);
+    timestamp += delta;
+    timestamps[1] = fromBits(timestamp);
+
+    for (size_t i = 2; i < length; ++i) {
+        int dodLength = 0;
+        if (reader.readBit()) {
+            if (!reader.readBit())
+                dodLength = 7;
+            else if (!reader.readBit())
+                dodLength = 9;
+            else if (!reader.readBit())
+                dodLength = 12;
+            else
+                dodLength = 64;
+        }
+        delta += unZigZag(reader.read(dodLength));
+        timestamp += delta;
+        timestamps[i] = fromBits(timestamp);
+    }
+}
+
+}
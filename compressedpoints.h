@@ -0,0 +1,84 @@
+#ifndef COMPRESSEDPOINTS_H
+#define COMPRESSEDPOINTS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace DataLoader {
+
+struct Point;
+
+/*
+ * Сжатое хранилище точек
+ *
+ * Функционал
+ *  1. Метки времени и значения хранятся в двух отдельных битовых потоках: для меток времени
+ *     кодируется разность вторых разностей (delta-of-delta) их двоичного представления, для значений -
+ *     XOR с предыдущим значением (схема Gorilla);
+ *  2. Потоки разбиты на блоки по BlockSize точек, каждый блок декодируется независимо;
+ *  3. Заголовок блока хранит минимум и максимум значений, поэтому для блоков, целиком попадающих
+ *     в столбец графика, декодирование не требуется;
+ *  4. Точки можно добавлять частями (append()), чтобы не держать в памяти исходный вектор целиком.
+ */
+class CompressedPoints
+{
+public:
+    static const size_t BlockSize = 1024;
+
+    struct Block {
+        uint64_t timestampsBit;
+        uint64_t valuesBit;
+        double min;
+        double max;
+    };
+
+    CompressedPoints() = default;
+    explicit CompressedPoints(const std::vector<Point> &points);
+
+    void append(const Point *points, size_t pointsQuan);
+    void shrinkToFit();
+
+    size_t size() const { return quan; }
+    size_t memoryUsage() const;
+
+    const Block &block(size_t index) const { return blocks[index]; }
+    size_t blockLength(size_t index) const;
+
+    void decodeValues(size_t index, double *values) const;
+    void decodeTimestamps(size_t index, double *timestamps) const;
+
+private:
+    class BitWriter;
+    class BitReader;
+
+    std::vector<uint64_t> timestampsStream;
+    std::vector<uint64_t> valuesStream;
+    std::vector<Block> blocks;
+    uint64_t timestampsBits = 0;
+    uint64_t valuesBits = 0;
+    size_t quan = 0;
+};
+
+// Последовательный доступ к значениям по индексу с декодированием блока при переходе в него
+struct CompressedValues {
+    explicit CompressedValues(const CompressedPoints &points) : points(&points) {}
+
+    double operator[](size_t i) const {
+        const size_t index = i / CompressedPoints::BlockSize;
+        if (index != cachedBlock) {
+            points->decodeValues(index, cache.data());
+            cachedBlock = index;
+        }
+        return cache[i % CompressedPoints::BlockSize];
+    }
+
+    const CompressedPoints *points;
+    mutable std::array<double, CompressedPoints::BlockSize> cache;
+    mutable size_t cachedBlock = SIZE_MAX;
+};
+
+}
+
+#endif // COMPRESSEDPOINTS_H
@@ -0,0 +1,285 @@
+#include "dataexporter.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace DataExporter {
+
+using DataLoader::FileData;
+using DataLoader::Point;
+
+namespace {
+
+const size_t ChunkSize = 4096;
+const size_t WriteBufferSize = 1 << 20;
+
+static_assert(ChunkSize >= DataLoader::CompressedPoints::BlockSize, "compressed block must fit in a chunk");
+
+/*
+ * Вызывает callback(const Point *points, size_t quan) для последовательных блоков точек [start, end).
+ * Точки текстового файла передаются без копирования, остальные форматы декодируются в один буфер
+ */
+template<typename Callback>
+void forEachChunk(const FileData &fileData, size_t start, size_t end, Callback callback)
+{
+    if (!fileData.raw && !fileData.compressed) {
+        for (size_t i = start; i < end; i += ChunkSize)
+            callback(fileData.points.data() + i, std::min(ChunkSize, end - i));
+        return;
+    }
+
+    std::array<Point, ChunkSize> chunk;
+
+    if (fileData.compressed) {
+        using DataLoader::CompressedPoints;
+        const auto &compressed = *fileData.compressed;
+        std::array<double, CompressedPoints::BlockSize> values, timestamps;
+
+        for (size_t block = start / CompressedPoints::BlockSize; block * CompressedPoints::BlockSize < end; ++block) {
+            const size_t blockStart = block * CompressedPoints::BlockSize;
+            compressed.decodeValues(block, values.data());
+            compressed.decodeTimestamps(block, timestamps.data());
+
+            const size_t from = std::max(start, blockStart);
+            const size_t to = std::min(end, blockStart + compressed.blockLength(block));
+            for (size_t i = from; i < to; ++i)
+                chunk[i - from] = Point(timestamps[i - blockStart], values[i - blockStart]);
+            callback(chunk.data(), to - from);
+        }
+        return;
+    }
+
+    const auto &raw = *fileData.raw;
+    DataLoader::visitValues(fileData, [&](const auto &values){
+        for (size_t i = start; i < end; i += ChunkSize) {
+            const size_t quan = std::min(ChunkSize, end - i);
+            for (size_t j = 0; j < quan; ++j)
+                chunk[j] = Point(raw.timestamp(i + j), values[i + j]);
+            callback(chunk.data(), quan);
+        }
+    });
+}
+
+// 17 значащих цифр достаточно, чтобы при чтении восстановить то же значение double (в том числе субнормальное)
+char *formatDouble(double value, char *out)
+{
+    return out + std::snprintf(out, 32, "%.17g", value);
+}
+
+class PointWriter
+{
+public:
+    // Локаль C для snprintf устанавливается только в потоке экспорта
+    PointWriter(std::FILE *file, Format format) :
+        file(file), format(format), buffer(WriteBufferSize), oldLocale(uselocale(DataLoader::cLocale())) {}
+    ~PointWriter()
+    {
+        flush();
+        uselocale(oldLocale);
+    }
+
+    void write(const Point &point)
+    {
+        // Самая длинная строка: 2 * ("-d.dddddddddddddddde-ddd") + ' ' + '\n'
+        if (used + 64 > buffer.size())
+            flush();
+
+        char *out = buffer.data() + used;
+        if (format == Format::Text) {
+            out = formatDouble(point.timestamp, out);
+            *out++ = ' ';
+            out = formatDouble(point.value, out);
+            *out++ = '\n';
+        } else {
+            std::memcpy(out, &point.timestamp, sizeof(double));
+            std::memcpy(out + sizeof(double), &point.value, sizeof(double));
+            out += 2 * sizeof(double);
+        }
+        used = static_cast<size_t>(out - buffer.data());
+    }
+
+    void writeText(const std::string &text)
+    {
+        flush();
+        std::fwrite(text.data(), 1, text.size(), file);
+    }
+
+    void flush()
+    {
+        std::fwrite(buffer.data(), 1, used, file);
+        used = 0;
+    }
+
+private:
+    std::FILE *file;
+    Format format;
+    std::vector<char> buffer;
+    size_t used = 0;
+    locale_t oldLocale;
+};
+
+void writeAll(const FileData &fileData, const Settings &settings, PointWriter &writer)
+{
+    forEachChunk(fileData, settings.start, settings.end, [&](const Point *points, size_t quan){
+        for (size_t i = 0; i < quan; ++i)
+            writer.write(points[i]);
+    });
+}
+
+// Для каждого из targetPoints/2 интервалов записываются точки минимума и максимума в порядке следования
+void writeMinMax(const FileData &fileData, const Settings &settings, PointWriter &writer)
+{
+    const size_t quan = settings.end - settings.start;
+    const size_t buckets = std::max<size_t>(settings.targetPoints / 2, 1);
+
+    size_t index = 0, bucket = 0;
+    size_t bucketEnd = quan / buckets;
+    size_t minIndex = 0, maxIndex = 0;
+    Point minPoint, maxPoint;
+
+    forEachChunk(fileData, settings.start, settings.end, [&](const Point *points, size_t chunkQuan){
+        for (size_t i = 0; i < chunkQuan; ++i, ++index) {
+            const Point &point = points[i];
+            if (index == 0 || index == (bucket * quan) / buckets) {
+                minPoint = maxPoint = point;
+                minIndex = maxIndex = index;
+            } else {
+                if (point.value < minPoint.value) {
+                    minPoint = point;
+                    minIndex = index;
+                }
+                if (point.value > maxPoint.value) {
+                    maxPoint = point;
+                    maxIndex = index;
+                }
+            }
+
+            if (index + 1 == bucketEnd) {
+                writer.write(minIndex <= maxIndex ? minPoint : maxPoint);
+                if (minIndex != maxIndex)
+                    writer.write(minIndex <= maxIndex ? maxPoint : minPoint);
+                ++bucket;
+                bucketEnd = ((bucket + 1) * quan) / buckets;
+            }
+        }
+    });
+}
+
+/*
+ * Largest-Triangle-Three-Buckets. Первый проход считает средние точки интервалов, второй выбирает
+ * в каждом интервале точку с наибольшей площадью треугольника (предыдущая выбранная, точка, среднее
+ * следующего интервала). Первая и последняя точки записываются всегда
+ */
+void writeLttb(const FileData &fileData, const Settings &settings, PointWriter &writer)
+{
+    const size_t quan = settings.end - settings.start;
+    const size_t buckets = std::max<size_t>(settings.targetPoints, 3) - 2;
+    const size_t middle = quan - 2;
+    auto bucketBegin = [&](size_t bucket){ return 1 + (bucket * middle) / buckets; };
+
+    std::vector<Point> averages(buckets + 1, Point(0.0, 0.0));
+    size_t index = 0, bucket = 0;
+    forEachChunk(fileData, settings.start, settings.end, [&](const Point *points, size_t chunkQuan){
+        for (size_t i = 0; i < chunkQuan; ++i, ++index) {
+            if (index == quan - 1)
+                averages[buckets] = points[i];
+            if (index == 0 || index == quan - 1)
+                continue;
+            while (index >= bucketBegin(bucket + 1))
+                ++bucket;
+            averages[bucket].timestamp += points[i].timestamp;
+            averages[bucket].value += points[i].value;
+        }
+    });
+    for (size_t i = 0; i < buckets; ++i) {
+        const double bucketQuan = static_cast<double>(bucketBegin(i + 1) - bucketBegin(i));
+        averages[i].timestamp /= bucketQuan;
+        averages[i].value /= bucketQuan;
+    }
+
+    Point selected, best, last;
+    double bestArea = -1.0;
+    index = 0;
+    bucket = 0;
+    forEachChunk(fileData, settings.start, settings.end, [&](const Point *points, size_t chunkQuan){
+        for (size_t i = 0; i < chunkQuan; ++i, ++index) {
+            const Point &point = points[i];
+            if (index == 0) {
+                selected = point;
+                writer.write(point);
+                continue;
+            }
+            if (index == quan - 1) {
+                last = point;
+                continue;
+            }
+
+            // Для последнего интервала третьей вершиной служит последняя точка (averages[buckets])
+            const Point &next = averages[bucket + 1];
+            const double area = std::abs((selected.timestamp - next.timestamp) * (point.value - selected.value)
+                                         - (selected.timestamp - point.timestamp) * (next.value - selected.value));
+            if (area > bestArea) {
+                bestArea = area;
+                best = point;
+            }
+
+            if (index + 1 == bucketBegin(bucket + 1)) {
+                writer.write(best);
+                selected = best;
+                bestArea = -1.0;
+                ++bucket;
+            }
+        }
+    });
+    writer.write(last);
+}
+
+}
+
+std::string exportData(const FileData &fileData, const std::string &fileName, const Settings &settings)
+{
+    if (settings.start >= settings.end || settings.end > fileData.size())
+        return "Nothing to export";
+
+    std::FILE *file = std::fopen(fileName.c_str(), settings.format == Format::Text ? "w" : "wb");
+    if (!file)
+        return "Can't open file: " + fileName;
+
+    {
+        PointWriter writer(file, settings.format);
+        if (settings.format == Format::Text)
+            writer.writeText("# Exported by Plot Drawer\n# <timestamp>   <value>\n");
+
+        const size_t quan = settings.end - settings.start;
+        if (settings.decimation == Decimation::None || settings.targetPoints >= quan)
+            writeAll(fileData, settings, writer);
+        else if (settings.decimation == Decimation::MinMax || quan < 3)
+            writeMinMax(fileData, settings, writer);
+        else
+            writeLttb(fileData, settings, writer);
+    }
+
+    const bool failed = std::ferror(file) != 0;
+    if (std::fclose(file) != 0 || failed)
+        return "Can't write file: " + fileName;
+
+    if (settings.format == Format::Binary) {
+        std::FILE *descriptor = std::fopen((fileName + ".desc").c_str(), "w");
+        if (!descriptor)
+            return "Can't open file: " + fileName + ".desc";
+        std::fputs("# Exported by Plot Drawer\n"
+                   "type = float64\n"
+                   "channels = 2\n"
+                   "channel = 1\n"
+                   "timestamp_channel = 0\n", descriptor);
+        std::fclose(descriptor);
+    }
+
+    return std::string();
+}
+
+}
@@ -0,0 +1,35 @@
+#ifndef DATAEXPORTER_H
+#define DATAEXPORTER_H
+
+#include <string>
+
+#include "dataloader.h"
+
+/*
+ * Экспорт точек в файл
+ *
+ * Функционал
+ *  1. Записывает диапазон [start, end) целиком или прореженным до targetPoints точек
+ *     (минимум и максимум каждого интервала или LTTB);
+ *  2. Текстовый формат совпадает с *.plot, бинарный - чередующиеся float64 <timestamp> <value>
+ *     с дескриптором *.desc, который открывается как обычный файл;
+ *  3. Точки читаются и записываются блоками фиксированного размера, копия данных не создается.
+ */
+namespace DataExporter {
+
+enum class Decimation { None, MinMax, Lttb };
+enum class Format { Text, Binary };
+
+struct Settings {
+    size_t start;
+    size_t end;
+    Decimation decimation;
+    size_t targetPoints;
+    Format format;
+};
+
+std::string exportData(const DataLoader::FileData &fileData, const std::string &fileName, const Settings &settings);
+
+}
+
+#endif // DATAEXPORTER_H
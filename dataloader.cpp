@@ -1,17 +1,55 @@
 #include "dataloader.h"
 
 #include <fstream>
+#include <sstream>
+#include <algorithm>
 #include <clocale>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace DataLoader {
 
+struct RawDescriptor {
+    std::string file;
+    SampleType type = SampleType::Int16;
+    size_t channels = 1;
+    size_t channel = 0;
+    size_t offset = 0;
+    double sampleRate = 0.0;
+    long timestampChannel = -1;
+};
+
+const size_t PointsChunk = 64 * CompressedPoints::BlockSize;
+
 std::string readHeader(std::fstream &stream);
 Point readPoint(const std::string &line);
-std::vector<Point> readPoints(std::fstream &stream, std::string &error);
+double readDouble(const std::string &str);
+void readPoints(std::fstream &stream, FileData &fileData, size_t memoryLimit);
+bool reservePoints(FileData &fileData, std::shared_ptr<CompressedPoints> &compressed, size_t memoryLimit);
+void freePoints(std::vector<Point> &points);
+RawDescriptor readDescriptor(const std::string &descriptorName, std::string &header, std::string &error);
+void setDescriptorValue(RawDescriptor &descriptor, const std::string &key, const std::string &value);
+size_t readSize(const std::string &value);
+size_t sampleSize(SampleType type);
+bool mapRawFile(const RawDescriptor &descriptor, RawSamples &samples, std::string &error);
+
+bool hasSuffix(const std::string &str, const std::string &suffix)
+{
+    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
 
-FileData loadMeasurementData(const std::string &fileName)
+FileData loadMeasurementData(const std::string &fileName, size_t memoryLimit)
 {
+    if (hasSuffix(fileName, ".desc"))
+        return loadRawData(fileName);
+
     FileData fileData;
 
     std::fstream in(fileName);
@@ -21,7 +59,7 @@ FileData loadMeasurementData(const std::string &fileName)
     }
 
     fileData.header = readHeader(in);
-    fileData.points = readPoints(in, fileData.error);
+    readPoints(in, fileData, memoryLimit);
 
     return fileData;
 }
@@ -39,10 +77,12 @@ std::string readHeader(std::fstream &stream)
     return out;
 }
 
-std::vector<Point> readPoints(std::fstream &stream, std::string &error)
+void readPoints(std::fstream &stream, FileData &fileData, size_t memoryLimit)
 {
     std::string line;
-    std::vector<Point> vec;
+    auto &vec = fileData.points;
+    auto &error = fileData.error;
+    std::shared_ptr<CompressedPoints> compressed;
     Point p;
 
     while (std::getline(stream, line)) {
@@ -53,6 +93,8 @@ std::vector<Point> readPoints(std::fstream &stream, std::string &error)
 
         try {
             p = readPoint(line);
+            if (vec.size() == (compressed ? PointsChunk : vec.capacity()) && !reservePoints(fileData, compressed, memoryLimit))
+                return;
             vec.push_back(p);
         }
         catch (std::invalid_argument &e) {
@@ -67,7 +109,60 @@ std::vector<Point> readPoints(std::fstream &stream, std::string &error)
         }
     }
 
-    return vec;
+    if (compressed) {
+        compressed->append(vec.data(), vec.size());
+        compressed->shrinkToFit();
+        freePoints(vec);
+        fileData.compressed = compressed;
+    }
+    fileData.peakLoadMemory = std::max(fileData.peakLoadMemory, memoryUsage(fileData).total());
+}
+
+/*
+ * Выделяет место под следующие точки. Пока вектор помещается в memoryLimit, его емкость удваивается
+ * (на время перераспределения в памяти находятся оба буфера), иначе прочитанные точки сжимаются,
+ * а вектор далее служит буфером на PointsChunk точек. Возвращает false, если не помещаются и сжатые точки.
+ */
+bool reservePoints(FileData &fileData, std::shared_ptr<CompressedPoints> &compressed, size_t memoryLimit)
+{
+    auto &vec = fileData.points;
+
+    if (!compressed) {
+        const size_t newCapacity = std::max(PointsChunk, 2 * vec.capacity());
+        const size_t usage = (vec.capacity() + newCapacity) * sizeof(Point);
+        if (memoryLimit == 0 || usage <= memoryLimit) {
+            vec.reserve(newCapacity);
+            fileData.peakLoadMemory = std::max(fileData.peakLoadMemory, usage);
+            return true;
+        }
+
+        compressed = std::make_shared<CompressedPoints>();
+        fileData.error += "Points don't fit into the memory limit and are stored compressed\n";
+    }
+
+    // Сжимаются только полные блоки, остаток переносится в начало буфера
+    const size_t blocksPoints = vec.size() - vec.size() % CompressedPoints::BlockSize;
+    compressed->append(vec.data(), blocksPoints);
+    fileData.peakLoadMemory = std::max(fileData.peakLoadMemory, compressed->memoryUsage() + vec.capacity() * sizeof(Point));
+
+    std::vector<Point> rest(vec.begin() + static_cast<ptrdiff_t>(blocksPoints), vec.end());
+    freePoints(vec);
+    vec.reserve(PointsChunk);
+    vec.insert(vec.end(), rest.begin(), rest.end());
+
+    if (compressed->memoryUsage() + PointsChunk * sizeof(Point) > memoryLimit) {
+        fileData.error += "Memory limit exceeded after " + std::to_string(compressed->size()) + " points, file isn't loaded\n";
+        compressed.reset();
+        freePoints(vec);
+        return false;
+    }
+
+    return true;
+}
+
+void freePoints(std::vector<Point> &points)
+{
+    std::vector<Point>().swap(points);
 }
 
 // std::from_chars поддержака добавлена недавно: https://gcc.gnu.org/pipermail/gcc-patches/2020-July/550331.html
@@ -80,8 +175,8 @@ Point readPoint(const std::string &line)
     std::setlocale(LC_NUMERIC,"C");
 
     if ( (pos = line.find(" ")) != std::string::npos ) {
-        p.timestamp = std::stod(line.substr(0, pos));
-        p.value = std::stod(line.substr(pos+1));
+        p.timestamp = readDouble(line.substr(0, pos));
+        p.value = readDouble(line.substr(pos+1));
     } else {
         throw std::invalid_argument("wrong format");
     }
@@ -91,4 +186,295 @@ Point readPoint(const std::string &line)
     return p;
 }
 
+// Используется для всех текстовых файлов. В отличие от std::stod принимает субнормальные значения
+// (strtod сообщает для них ERANGE), ошибкой считается только переполнение
+double readDouble(const std::string &str)
+{
+    char *end;
+    errno = 0;
+    const double value = std::strtod(str.c_str(), &end);
+    if (end == str.c_str())
+        throw std::invalid_argument("readDouble");
+    if (errno == ERANGE && std::isinf(value))
+        throw std::out_of_range("readDouble");
+
+    return value;
+}
+
+// Заменяет points сжатым хранилищем и освобождает память исходного вектора
+void compressPoints(FileData &fileData)
+{
+    if (fileData.points.empty())
+        return;
+
+    fileData.compressed = std::make_shared<CompressedPoints>(fileData.points);
+    fileData.peakLoadMemory = std::max(fileData.peakLoadMemory, memoryUsage(fileData).total());
+    freePoints(fileData.points);
+}
+
+// Статистика не строится, если вместе с данными файла не помещается в memoryLimit
+void buildStatistics(FileData &fileData, size_t memoryLimit)
+{
+    const size_t quan = fileData.size();
+    if (quan == 0)
+        return;
+
+    const size_t usage = memoryUsage(fileData).total() + RangeStatistics::estimateMemoryUsage(quan);
+    if (memoryLimit != 0 && usage > memoryLimit) {
+        fileData.error += "Statistics don't fit into the memory limit and aren't built\n";
+        return;
+    }
+
+    visitValues(fileData, [&](const auto &values){
+        double minValue = values[0], maxValue = values[0];
+        for (size_t i = 1; i < quan; ++i) {
+            minValue = std::min<double>(minValue, values[i]);
+            maxValue = std::max<double>(maxValue, values[i]);
+        }
+        fileData.statistics = std::make_shared<RangeStatistics>(values, quan, minValue, maxValue);
+    });
+    fileData.peakLoadMemory = std::max(fileData.peakLoadMemory, memoryUsage(fileData).total());
+}
+
+MemoryUsage memoryUsage(const FileData &fileData)
+{
+    MemoryUsage usage;
+    usage.points = fileData.points.capacity() * sizeof(Point);
+    usage.compressed = fileData.compressed ? fileData.compressed->memoryUsage() : 0;
+    usage.statistics = fileData.statistics ? fileData.statistics->memoryUsage() : 0;
+    usage.text = fileData.header.capacity() + fileData.error.capacity();
+    usage.mapped = fileData.raw ? fileData.raw->mappingSize : 0;
+    return usage;
+}
+
+locale_t cLocale()
+{
+    static locale_t locale = newlocale(LC_NUMERIC_MASK, "C", nullptr);
+    return locale;
+}
+
+// Половина физической памяти, 0 (без ограничения), если ее размер не удалось определить
+size_t defaultMemoryLimit()
+{
+    const long pages = ::sysconf(_SC_PHYS_PAGES);
+    const long pageSize = ::sysconf(_SC_PAGE_SIZE);
+    if (pages <= 0 || pageSize <= 0)
+        return 0;
+
+    return static_cast<size_t>(pages) / 2 * static_cast<size_t>(pageSize);
+}
+
+/*
+ * Дескриптор бинарного файла - текстовый файл со строками "<ключ> = <значение>":
+ *   file              - имя бинарного файла (относительно дескриптора), по умолчанию имя дескриптора без .desc
+ *   type              - тип отсчетов: int16, int32, float32 или float64 (little-endian)
+ *   channels          - количество чередующихся каналов, по умолчанию 1
+ *   channel           - отображаемый канал, по умолчанию 0
+ *   offset            - размер заголовка бинарного файла в байтах, по умолчанию 0
+ *   sample_rate       - частота дискретизации, Гц
+ *   timestamp_channel - канал с метками времени (если sample_rate не задана)
+ * Строки, начинающиеся с '#', попадают в FileData::header, как и в файлах *.plot
+ */
+FileData loadRawData(const std::string &descriptorName)
+{
+    FileData fileData;
+
+    auto descriptor = readDescriptor(descriptorName, fileData.header, fileData.error);
+    if ( !fileData.error.empty() )
+        return fileData;
+
+    auto samples = std::make_shared<RawSamples>();
+    if ( mapRawFile(descriptor, *samples, fileData.error) )
+        fileData.raw = samples;
+
+    return fileData;
+}
+
+RawDescriptor readDescriptor(const std::string &descriptorName, std::string &header, std::string &error)
+{
+    RawDescriptor descriptor;
+
+    std::fstream in(descriptorName);
+    if ( !in ) {
+        error = "Can't open file: " + descriptorName;
+        return descriptor;
+    }
+    header = readHeader(in);
+
+    descriptor.file = descriptorName.substr(0, descriptorName.size() - std::strlen(".desc"));
+
+    std::string line, key, value;
+    while (std::getline(in, line)) {
+        if ( !line.empty() && line.back() == '\r' )
+            line.resize(line.size()-1);
+        if ( line.empty() || line.front() == '#' )
+            continue;
+
+        auto pos = line.find('=');
+        std::istringstream keyStream(line.substr(0, pos)), valueStream(pos == std::string::npos ? "" : line.substr(pos+1));
+        if ( !(keyStream >> key) || !(valueStream >> value) ) {
+            error += "wrong format: " + line + "\n";
+            continue;
+        }
+
+        try {
+            setDescriptorValue(descriptor, key, value);
+        }
+        catch (std::invalid_argument &e) {
+            error += "invalid_argument: " + line + " (" + e.what() + ")\n";
+        }
+        catch (std::out_of_range &e) {
+            error += "out_of_range: " + line + " (" + e.what() + ")\n";
+        }
+    }
+
+    if (descriptor.channel >= descriptor.channels)
+        error += "channel must be less than channels\n";
+    if (descriptor.timestampChannel >= static_cast<long>(descriptor.channels))
+        error += "timestamp_channel must be less than channels\n";
+    if (descriptor.sampleRate <= 0.0 && descriptor.timestampChannel < 0)
+        error += "sample_rate or timestamp_channel must be set\n";
+
+    return descriptor;
+}
+
+void setDescriptorValue(RawDescriptor &descriptor, const std::string &key, const std::string &value)
+{
+    if (key == "file") {
+        auto slash = descriptor.file.rfind('/');
+        descriptor.file = (value.front() == '/' || slash == std::string::npos) ? value : descriptor.file.substr(0, slash+1) + value;
+    } else if (key == "type") {
+        if (value == "int16")
+            descriptor.type = SampleType::Int16;
+        else if (value == "int32")
+            descriptor.type = SampleType::Int32;
+        else if (value == "float32")
+            descriptor.type = SampleType::Float32;
+        else if (value == "float64")
+            descriptor.type = SampleType::Float64;
+        else
+            throw std::invalid_argument("unknown sample type");
+    } else if (key == "channels") {
+        descriptor.channels = readSize(value);
+        if (descriptor.channels == 0)
+            throw std::invalid_argument("channels must be positive");
+    } else if (key == "channel") {
+        descriptor.channel = readSize(value);
+    } else if (key == "offset") {
+        descriptor.offset = readSize(value);
+    } else if (key == "sample_rate") {
+        const auto oldLocale=std::setlocale(LC_NUMERIC,nullptr);
+        std::setlocale(LC_NUMERIC,"C");
+        descriptor.sampleRate = std::stod(value);
+        std::setlocale(LC_NUMERIC,oldLocale);
+    } else if (key == "timestamp_channel") {
+        descriptor.timestampChannel = std::stol(value);
+    } else {
+        throw std::invalid_argument("unknown key");
+    }
+}
+
+// std::stoul принимает "-1" и возвращает ULONG_MAX, поэтому знак проверяется отдельно
+size_t readSize(const std::string &value)
+{
+    if (value.front() == '-')
+        throw std::invalid_argument("value must not be negative");
+
+    return std::stoul(value);
+}
+
+size_t sampleSize(SampleType type)
+{
+    switch (type) {
+    case SampleType::Int16:   return sizeof(int16_t);
+    case SampleType::Int32:   return sizeof(int32_t);
+    case SampleType::Float32: return sizeof(float);
+    case SampleType::Float64: return sizeof(double);
+    }
+    return 0;
+}
+
+bool mapRawFile(const RawDescriptor &descriptor, RawSamples &samples, std::string &error)
+{
+    const uint16_t endianProbe = 1;
+    if (*reinterpret_cast<const uint8_t *>(&endianProbe) != 1) {
+        error = "Raw files are little-endian, big-endian hosts are not supported";
+        return false;
+    }
+
+    const size_t size = sampleSize(descriptor.type);
+    if (descriptor.offset % size != 0) {
+        error = "offset must be a multiple of the sample size";
+        return false;
+    }
+
+    int fd = ::open(descriptor.file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "Can't open file: " + descriptor.file;
+        return false;
+    }
+
+    struct stat fileStat;
+    if (::fstat(fd, &fileStat) < 0) {
+        error = "Can't get file size: " + descriptor.file;
+        ::close(fd);
+        return false;
+    }
+    if (static_cast<size_t>(fileStat.st_size) < descriptor.offset) {
+        error = "offset is beyond the end of file: " + descriptor.file;
+        ::close(fd);
+        return false;
+    }
+    if (static_cast<size_t>(fileStat.st_size) == descriptor.offset) {
+        error = "File has't contain any samples: " + descriptor.file;
+        ::close(fd);
+        return false;
+    }
+
+    samples.mappingSize = static_cast<size_t>(fileStat.st_size);
+    samples.mapping = ::mmap(nullptr, samples.mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (samples.mapping == MAP_FAILED) {
+        samples.mapping = nullptr;
+        error = "Can't map file: " + descriptor.file;
+        return false;
+    }
+
+    const auto data = static_cast<const char *>(samples.mapping) + descriptor.offset;
+    samples.type = descriptor.type;
+    samples.stride = descriptor.channels;
+    samples.quan = (samples.mappingSize - descriptor.offset) / (size * descriptor.channels);
+    samples.values = data + descriptor.channel * size;
+    samples.sampleRate = descriptor.sampleRate;
+    if (descriptor.sampleRate <= 0.0)
+        samples.timestamps = data + static_cast<size_t>(descriptor.timestampChannel) * size;
+
+    if (samples.quan == 0) {
+        error = "File has't contain any samples: " + descriptor.file;
+        return false;
+    }
+
+    return true;
+}
+
+RawSamples::~RawSamples()
+{
+    if (mapping)
+        ::munmap(mapping, mappingSize);
+}
+
+double RawSamples::timestamp(size_t i) const
+{
+    if (sampleRate > 0.0)
+        return i / sampleRate;
+
+    switch (type) {
+    case SampleType::Int16:   return SampleValues<int16_t>{static_cast<const int16_t *>(timestamps), stride}[i];
+    case SampleType::Int32:   return SampleValues<int32_t>{static_cast<const int32_t *>(timestamps), stride}[i];
+    case SampleType::Float32: return SampleValues<float>{static_cast<const float *>(timestamps), stride}[i];
+    case SampleType::Float64: return SampleValues<double>{static_cast<const double *>(timestamps), stride}[i];
+    }
+    return 0.0;
+}
+
 }
@@ -1,9 +1,16 @@
 #ifndef DATALOADER_H
 #define DATALOADER_H
 
+#include <cstddef>
+#include <cstdint>
+#include <locale.h>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "compressedpoints.h"
+#include "rangestatistics.h"
+
 namespace DataLoader {
 
 struct Point {
@@ -13,13 +20,113 @@ struct Point {
     double value;
 };
 
+enum class SampleType { Int16, Int32, Float32, Float64 };
+
+/*
+ * Отсчеты одного канала бинарного файла, отображенного в память (mmap)
+ *
+ * Файл описывается дескриптором *.desc (см. loadRawData()), значения не копируются и
+ * не преобразуются: values указывает на первый отсчет канала, stride - шаг между отсчетами
+ * в элементах типа type.
+ */
+struct RawSamples {
+    RawSamples() = default;
+    RawSamples(const RawSamples &) = delete;
+    RawSamples &operator=(const RawSamples &) = delete;
+    ~RawSamples();
+
+    double timestamp(size_t i) const;
+
+    SampleType type = SampleType::Int16;
+    const void *values = nullptr;
+    size_t stride = 1;
+    size_t quan = 0;
+
+    double sampleRate = 0.0;
+    const void *timestamps = nullptr;   // канал времени, если sampleRate не задана
+
+    void *mapping = nullptr;
+    size_t mappingSize = 0;
+};
+
 struct FileData {
+    size_t size() const { return raw ? raw->quan : compressed ? compressed->size() : points.size(); }
+
     std::string header;
     std::vector<Point> points;
+    std::shared_ptr<const RawSamples> raw;
+    std::shared_ptr<const CompressedPoints> compressed;
+    std::shared_ptr<const RangeStatistics> statistics;
     std::string error;
+    size_t peakLoadMemory = 0;   // наибольший объем памяти точек во время загрузки, байт
 };
 
-FileData loadMeasurementData(const std::string &fileName);
+// Память, занимаемая данными файла, байт
+struct MemoryUsage {
+    size_t total() const { return points + compressed + statistics + text; }
+
+    size_t points = 0;
+    size_t compressed = 0;
+    size_t statistics = 0;
+    size_t text = 0;     // header и error
+    size_t mapped = 0;   // отображенный бинарный файл: страницы вытесняемы, поэтому в total() не входят
+};
+
+// Доступ к значениям по индексу для шаблонных функций отрисовки
+template<typename T>
+struct SampleValues {
+    T operator[](size_t i) const { return data[i*stride]; }
+    const T *data;
+    size_t stride;
+};
+
+struct PointValues {
+    double operator[](size_t i) const { return data[i].value; }
+    const Point *data;
+};
+
+// Вызывает visitor с объектом доступа к значениям, соответствующим способу хранения точек
+template<typename Visitor>
+void visitValues(const FileData &fileData, Visitor visitor)
+{
+    if (fileData.compressed) {
+        visitor(CompressedValues(*fileData.compressed));
+        return;
+    }
+
+    const auto &raw = fileData.raw;
+    if (!raw) {
+        visitor(PointValues{fileData.points.data()});
+        return;
+    }
+
+    switch (raw->type) {
+    case SampleType::Int16:
+        visitor(SampleValues<int16_t>{static_cast<const int16_t *>(raw->values), raw->stride});
+        break;
+    case SampleType::Int32:
+        visitor(SampleValues<int32_t>{static_cast<const int32_t *>(raw->values), raw->stride});
+        break;
+    case SampleType::Float32:
+        visitor(SampleValues<float>{static_cast<const float *>(raw->values), raw->stride});
+        break;
+    case SampleType::Float64:
+        visitor(SampleValues<double>{static_cast<const double *>(raw->values), raw->stride});
+        break;
+    }
+}
+
+// memoryLimit - ограничение памяти данных файла в байтах, 0 - без ограничения
+FileData loadMeasurementData(const std::string &fileName, size_t memoryLimit = 0);
+FileData loadRawData(const std::string &descriptorName);
+void compressPoints(FileData &fileData);
+void buildStatistics(FileData &fileData, size_t memoryLimit = 0);
+MemoryUsage memoryUsage(const FileData &fileData);
+size_t defaultMemoryLimit();
+
+// Локаль "C" для разбора и записи чисел в отдельных потоках (strtod_l(), uselocale()): Qt устанавливает
+// локаль из окружения, а setlocale, как в readPoint(), меняет ее для всего процесса
+locale_t cLocale();
 
 }
 
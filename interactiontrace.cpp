@@ -0,0 +1,52 @@
+#include "interactiontrace.h"
+
+#include <fstream>
+#include <sstream>
+#include <limits>
+
+namespace InteractionTrace {
+
+TraceData loadTrace(const std::string &fileName)
+{
+    TraceData traceData;
+
+    std::ifstream in(fileName);
+    if ( !in ) {
+        traceData.error = "Can't open file: " + fileName;
+        return traceData;
+    }
+
+    std::string line;
+    Request request;
+    while (std::getline(in, line)) {
+        if ( !line.empty() && line.back() == '\r' )
+            line.resize(line.size()-1);
+        if ( line.empty() || line.front() == '#' )
+            continue;
+
+        // std::istringstream использует локаль "C", поэтому setlocale, как в DataLoader, не нужен
+        std::istringstream stream(line);
+        if (stream >> request.time >> request.pixmapOffset >> request.scaleFactor
+                   >> request.width >> request.height)
+            traceData.requests.push_back(request);
+        else
+            traceData.error += "wrong format: " + line + "\n";
+    }
+
+    return traceData;
+}
+
+void writeHeader(std::ostream &stream)
+{
+    stream << "# Plot Drawer interaction trace\n"
+           << "# <time, ms> <pixmapOffset> <scaleFactor> <width> <height>\n";
+}
+
+void writeRequest(std::ostream &stream, const Request &request)
+{
+    stream.precision(std::numeric_limits<double>::max_digits10);
+    stream << request.time << ' ' << request.pixmapOffset << ' ' << request.scaleFactor << ' '
+           << request.width << ' ' << request.height << '\n';
+}
+
+}
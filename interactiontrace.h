@@ -0,0 +1,39 @@
+#ifndef INTERACTIONTRACE_H
+#define INTERACTIONTRACE_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+ * Запись и чтение трассы запросов отрисовки
+ *
+ * Формат файла аналогичен *.plot: строки, начинающиеся с '#', пропускаются,
+ * далее по одному запросу в строке:
+ *   <время от начала записи, мс> <pixmapOffset> <scaleFactor> <ширина> <высота>
+ */
+namespace InteractionTrace {
+
+struct Request {
+    Request() = default;
+    Request(double t, int offset, double scale, int w, int h)
+        : time(t), pixmapOffset(offset), scaleFactor(scale), width(w), height(h) {}
+    double time;
+    int pixmapOffset;
+    double scaleFactor;
+    int width;
+    int height;
+};
+
+struct TraceData {
+    std::vector<Request> requests;
+    std::string error;
+};
+
+TraceData loadTrace(const std::string &fileName);
+void writeHeader(std::ostream &stream);
+void writeRequest(std::ostream &stream, const Request &request);
+
+}
+
+#endif // INTERACTIONTRACE_H
@@ -0,0 +1,79 @@
+#include "livebuffer.h"
+
+#include <algorithm>
+
+LiveBuffer::LiveBuffer(size_t capacity) :
+    ring(capacity),
+    blocks((capacity + BlockSize - 1) / BlockSize)
+{
+
+}
+
+void LiveBuffer::append(const std::vector<DataLoader::Point> &batch)
+{
+    QMutexLocker locker(&mutex);
+    for (const auto &point : batch)
+        push(point);
+
+    received += batch.size();
+}
+
+void LiveBuffer::push(const DataLoader::Point &point)
+{
+    if (head % BlockSize == 0)
+        headBlock = {point.value, point.value};
+    else
+        headBlock = {std::min(headBlock.min, point.value), std::max(headBlock.max, point.value)};
+
+    ring[head++] = point;
+
+    if (head % BlockSize == 0 || head == ring.size())
+        blocks[(head-1) / BlockSize] = headBlock;
+
+    if (head == ring.size()) {
+        head = 0;
+        full = true;
+    }
+}
+
+// Точки копируются в хронологическом порядке. Вызывающий заранее резервирует capacity() точек,
+// тогда копирование обходится без выделения памяти
+void LiveBuffer::copyTo(std::vector<DataLoader::Point> &points, double &minValue, double &maxValue)
+{
+    QMutexLocker locker(&mutex);
+
+    points.clear();
+    if (full)
+        points.insert(points.end(), ring.cbegin() + static_cast<ptrdiff_t>(head), ring.cend());
+    points.insert(points.end(), ring.cbegin(), ring.cbegin() + static_cast<ptrdiff_t>(head));
+
+    if (points.empty())
+        return;
+
+    const size_t headBlockIndex = head / BlockSize;
+    const size_t blockEnd = std::min((headBlockIndex + 1) * BlockSize, ring.size());
+    const size_t blocksQuan = full ? blocks.size() : headBlockIndex;
+
+    minValue = points.back().value;
+    maxValue = points.back().value;
+
+    for (size_t i = 0; i < blocksQuan; ++i) {
+        if (i == headBlockIndex)
+            continue;
+        minValue = std::min(minValue, blocks[i].min);
+        maxValue = std::max(maxValue, blocks[i].max);
+    }
+
+    // Блок, в который идет запись, содержит новые точки [начало блока, head) и еще не
+    // перезаписанные старые точки [head, конец блока)
+    if (head % BlockSize != 0) {
+        minValue = std::min(minValue, headBlock.min);
+        maxValue = std::max(maxValue, headBlock.max);
+    }
+    if (full) {
+        for (size_t i = head; i < blockEnd; ++i) {
+            minValue = std::min(minValue, ring[i].value);
+            maxValue = std::max(maxValue, ring[i].value);
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef LIVEBUFFER_H
+#define LIVEBUFFER_H
+
+#include <QMutex>
+#include <QtGlobal>
+#include <atomic>
+#include <vector>
+
+#include "dataloader.h"
+
+/*
+ * Кольцевой буфер точек для потоковых данных
+ *
+ * Функционал
+ *  1. Хранит не более capacity() последних точек, память выделяется один раз в конструкторе;
+ *  2. Минимум и максимум окна поддерживаются по блокам из BlockSize точек при каждом добавлении,
+ *     поэтому для их получения не нужен полный проход по буферу;
+ *  3. append() и copyTo() вызываются из разных потоков и защищены мьютексом.
+ */
+class LiveBuffer
+{
+public:
+    explicit LiveBuffer(size_t capacity);
+
+    void append(const std::vector<DataLoader::Point> &batch);
+    void copyTo(std::vector<DataLoader::Point> &points, double &minValue, double &maxValue);
+
+    size_t capacity() const { return ring.size(); }
+    quint64 receivedPoints() const { return received; }
+
+private:
+    struct Block {
+        double min;
+        double max;
+    };
+
+    void push(const DataLoader::Point &point);
+
+    static const size_t BlockSize = 4096;
+
+    QMutex mutex;
+    std::vector<DataLoader::Point> ring;
+    std::vector<Block> blocks;
+    Block headBlock = {0.0, 0.0};
+    size_t head = 0;
+    bool full = false;
+    std::atomic<quint64> received{0};
+};
+
+#endif // LIVEBUFFER_H
@@ -0,0 +1,163 @@
+#include "livesource.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+const int PollTimeoutMs = 100;
+const size_t ReadChunkSize = 64 * 1024;
+
+}
+
+LiveSource::LiveSource(LiveBuffer &buffer, const std::string &socketPath, QObject *parent) :
+    QThread(parent), buffer(buffer), socketPath(socketPath)
+{
+
+}
+
+LiveSource::~LiveSource()
+{
+    stop();
+}
+
+void LiveSource::stop()
+{
+    abort = true;
+    wait();
+}
+
+void LiveSource::run()
+{
+    if (socketPath.empty()) {
+        readStream(STDIN_FILENO);
+        return;
+    }
+
+    int server = listenSocket();
+    if (server < 0)
+        return;
+
+    while (!abort) {
+        if (!waitReadable(server))
+            continue;
+
+        int client = ::accept(server, nullptr, nullptr);
+        if (client < 0)
+            continue;
+
+        readStream(client);
+        ::close(client);
+    }
+
+    ::close(server);
+    ::unlink(socketPath.c_str());
+}
+
+int LiveSource::listenSocket()
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        emit errorOccurred(QString("Socket path is too long: %1").arg(socketPath.c_str()));
+        return -1;
+    }
+    std::strcpy(address.sun_path, socketPath.c_str());
+
+    int server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ::unlink(socketPath.c_str());
+    if (server < 0
+            || ::bind(server, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0
+            || ::listen(server, 1) < 0) {
+        emit errorOccurred(QString("Can't listen on %1: %2").arg(socketPath.c_str(), std::strerror(errno)));
+        if (server >= 0)
+            ::close(server);
+        return -1;
+    }
+
+    return server;
+}
+
+// Ожидание с таймаутом, чтобы поток проверял флаг abort и при отсутствии данных
+bool LiveSource::waitReadable(int fd)
+{
+    pollfd pfd = {fd, POLLIN, 0};
+    return ::poll(&pfd, 1, PollTimeoutMs) > 0;
+}
+
+void LiveSource::readStream(int fd)
+{
+    std::string chunk;
+    chunk.reserve(2 * ReadChunkSize);
+    std::vector<char> readBuffer(ReadChunkSize);
+    bool skipLine = false;
+
+    while (!abort) {
+        if (!waitReadable(fd))
+            continue;
+
+        auto bytes = ::read(fd, readBuffer.data(), readBuffer.size());
+        if (bytes <= 0)
+            break;
+
+        const char *data = readBuffer.data();
+        size_t size = static_cast<size_t>(bytes);
+        // Остаток отброшенной строки пропускается до ее конца
+        if (skipLine) {
+            auto newline = static_cast<const char *>(std::memchr(data, '\n', size));
+            if (!newline)
+                continue;
+            size -= static_cast<size_t>(newline + 1 - data);
+            data = newline + 1;
+            skipLine = false;
+        }
+
+        chunk.append(data, size);
+        parseLines(chunk);
+
+        // Строка длиннее ReadChunkSize отбрасывается, как и строки неверного формата, поэтому chunk
+        // не превышает 2 * ReadChunkSize, даже если источник не передает '\n'
+        if (chunk.size() > ReadChunkSize) {
+            chunk.clear();
+            skipLine = true;
+        }
+    }
+}
+
+// Разбирает все полные строки chunk, незавершенная строка остается в chunk до следующего чтения
+void LiveSource::parseLines(std::string &chunk)
+{
+    batch.clear();
+    DataLoader::Point point;
+
+    size_t lineStart = 0, lineEnd;
+    while ((lineEnd = chunk.find('\n', lineStart)) != std::string::npos) {
+        chunk[lineEnd] = '\0';
+        const char *line = chunk.c_str() + lineStart;
+        if (*line != '#' && *line != '\0' && *line != '\r' && readPoint(line, point))
+            batch.push_back(point);
+        lineStart = lineEnd + 1;
+    }
+    chunk.erase(0, lineStart);
+
+    if (!batch.empty())
+        buffer.append(batch);
+}
+
+bool LiveSource::readPoint(const char *line, DataLoader::Point &point)
+{
+    char *end;
+    point.timestamp = strtod_l(line, &end, DataLoader::cLocale());
+    if (end == line)
+        return false;
+
+    line = end;
+    point.value = strtod_l(line, &end, DataLoader::cLocale());
+    return end != line;
+}
@@ -0,0 +1,52 @@
+#ifndef LIVESOURCE_H
+#define LIVESOURCE_H
+
+#include <QThread>
+#include <QString>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "dataloader.h"
+#include "livebuffer.h"
+
+/*
+ * Источник потоковых данных
+ *
+ * Функционал
+ *  1. В отдельном потоке читает строки "<timestamp> <value>" из stdin (пустой socketPath)
+ *     или из локального UNIX-сокета, который создается по пути socketPath;
+ *  2. Строки разбираются пачками и добавляются в LiveBuffer одной блокировкой на пачку;
+ *  3. Строки, начинающиеся с '#', и пустые строки пропускаются, как и в файлах *.plot.
+ */
+class LiveSource : public QThread
+{
+    Q_OBJECT
+
+public:
+    LiveSource(LiveBuffer &buffer, const std::string &socketPath, QObject *parent = nullptr);
+    ~LiveSource() override;
+
+    void stop();
+
+signals:
+    void errorOccurred(const QString &error);
+
+protected:
+    void run() override;
+
+private:
+    int listenSocket();
+    bool waitReadable(int fd);
+    void readStream(int fd);
+    void parseLines(std::string &chunk);
+    bool readPoint(const char *line, DataLoader::Point &point);
+
+    LiveBuffer &buffer;
+    std::string socketPath;
+    std::atomic<bool> abort{false};
+
+    std::vector<DataLoader::Point> batch;
+};
+
+#endif // LIVESOURCE_H
@@ -1,11 +1,46 @@
 #include "mainwindow.h"
 #include <QApplication>
+#include <QCommandLineParser>
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption liveOption("live", "Show streamed \"<timestamp> <value>\" lines from stdin (\"-\") "
+                                          "or from a UNIX socket created at <source>.", "source");
+    QCommandLineOption capacityOption("capacity", "Number of last points kept in live mode.", "points", "1000000");
+    QCommandLineOption fpsOption("fps", "Maximum frame rate in live mode, 1-1000.", "fps", "25");
+    QCommandLineOption memoryLimitOption("memory-limit", "Memory limit for loaded data, MB (0 - no limit). "
+                                                         "By default a half of physical memory.", "MB");
+    parser.addOption(liveOption);
+    parser.addOption(capacityOption);
+    parser.addOption(fpsOption);
+    parser.addOption(memoryLimitOption);
+    parser.process(a);
+
     MainWindow w;
     w.show();
 
+    if (parser.isSet(memoryLimitOption)) {
+        bool ok;
+        auto memoryLimit = parser.value(memoryLimitOption).toULongLong(&ok);
+        if (!ok)
+            parser.showHelp(1);
+
+        w.setMemoryLimit(static_cast<size_t>(memoryLimit) << 20);
+    }
+
+    if (parser.isSet(liveOption)) {
+        auto source = parser.value(liveOption);
+        auto capacity = parser.value(capacityOption).toULongLong();
+        auto frameRate = parser.value(fpsOption).toInt();
+        if (capacity < 2 || frameRate <= 0 || frameRate > 1000)
+            parser.showHelp(1);
+
+        w.startLiveSource(source == "-" ? QString() : source, capacity, frameRate);
+    }
+
     return a.exec();
 }
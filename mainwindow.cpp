@@ -4,7 +4,12 @@
 #include <QFileDialog>
 #include <QStandardPaths>
 #include <QFileInfo>
+#include <QInputDialog>
+#include <algorithm>
 #include <cmath>
+#include <limits>
+
+#include "dataexporter.h"
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
@@ -16,20 +21,30 @@ MainWindow::MainWindow(QWidget *parent) :
 
     connect(ui->actionOpen, &QAction::triggered, this, &MainWindow::open);
     connect(ui->actionExit, &QAction::triggered, this, &MainWindow::close);
-    connect(ui->actionFile_info, &QAction::triggered, msgBox, &QMessageBox::show);
+    connect(ui->actionFile_info, &QAction::triggered, this, &MainWindow::showFileInfo);
+    connect(ui->actionRecord_trace, &QAction::toggled, this, &MainWindow::recordTrace);
+    connect(ui->actionDensity_map, &QAction::toggled, &thread, &RenderThread::setDensityMode);
+
+    fileDataLoading = new QFutureWatcher<std::shared_ptr<DataLoader::FileData>>(this);
+    connect(fileDataLoading, &QFutureWatcher<std::shared_ptr<DataLoader::FileData>>::finished, this, &MainWindow::finished);
 
-    fileDataLoading = new QFutureWatcher<DataLoader::FileData>(this);
-    connect(fileDataLoading, &QFutureWatcher<DataLoader::FileData>::finished, this, &MainWindow::finished);
+    dataExporting = new QFutureWatcher<std::string>(this);
+    connect(dataExporting, &QFutureWatcher<std::string>::finished, this, &MainWindow::exported);
+    connect(ui->actionExport, &QAction::triggered, this, &MainWindow::exportData);
 
     connect(&thread, &RenderThread::plotRendered, ui->centralWidget, &PlotDrawer::updatePlot);
     qRegisterMetaType<size_t>("size_t");
     connect(&thread, &RenderThread::scaleMinMaxUpdated, ui->centralWidget, &PlotDrawer::updateMinMaxScale);
     connect(ui->centralWidget, &PlotDrawer::render, &thread, &RenderThread::render);
+    qRegisterMetaType<RangeStatistics::Result>("RangeStatistics::Result");
+    connect(&thread, &RenderThread::statisticsUpdated, this, &MainWindow::updateStatistics);
+    ui->menuView->addAction(ui->statisticsDock->toggleViewAction());
 }
 
 MainWindow::~MainWindow()
 {
     fileDataLoading->waitForFinished();
+    dataExporting->waitForFinished();
     delete ui;
 }
 
@@ -42,7 +57,7 @@ void MainWindow::open()
     static QString lastOpenFile = QStandardPaths::writableLocation(QStandardPaths::HomeLocation);
 
     QString fileName = QFileDialog::getOpenFileName(this, tr("Select Files"),
-                                                    lastOpenFile, "*.plot;;All files(*)");
+                                                    lastOpenFile, "*.plot *.desc;;All files(*)");
 
     if (fileName.isNull())
         return;
@@ -51,26 +66,175 @@ void MainWindow::open()
     setWindowTitle(fileInfo.fileName());
 
     lastOpenFile = fileInfo.path();
-    fileDataLoading->setFuture( QtConcurrent::run(DataLoader::loadMeasurementData, fileName.toStdString()) );
+    const bool compress = ui->actionCompress_in_memory->isChecked();
+
+    // Ограничение относится к новому файлу, поэтому предыдущий освобождается до загрузки (на экране
+    // остается его последний кадр). Если предыдущий файл еще читает экспорт, память остается занятой
+    // и вычитается из ограничения
+    thread.setPlotFileData(std::make_shared<DataLoader::FileData>());
+    ui->actionExport->setEnabled(false);
+    size_t limit = memoryLimit;
+    auto heldFileData = exportedFileData.lock();
+    if (memoryLimit != 0 && heldFileData)
+        limit -= std::min(memoryLimit - 1, DataLoader::memoryUsage(*heldFileData).total());
+    heldFileData.reset();
+
+    // Результат QFuture копируется при получении, поэтому передается через shared_ptr
+    fileDataLoading->setFuture( QtConcurrent::run([name = fileName.toStdString(), compress, limit](){
+        auto fileData = std::make_shared<DataLoader::FileData>(DataLoader::loadMeasurementData(name, limit));
+        if (compress)
+            DataLoader::compressPoints(*fileData);
+        DataLoader::buildStatistics(*fileData, limit);
+        return fileData;
+    }) );
 }
 
 void MainWindow::finished()
 {
-    auto fileData = fileDataLoading->result();
+    // QFuture хранит свою копию указателя до следующей загрузки, поэтому данные из него перемещаются;
+    // экспорт, если он еще идет, читает предыдущий файл через свой указатель
+    auto fileData = std::make_shared<DataLoader::FileData>(std::move(*fileDataLoading->result()));
 
-    auto msg = createMsgAboutFileLoad(fileData);
-    msgBox->setText(msg);
+    fileInfo = createMsgAboutFileLoad(*fileData);
     ui->actionFile_info->setEnabled(true);
+    ui->actionExport->setEnabled(true);
 
     thread.setPlotFileData(fileData);
+    // Статистика нового файла придет с первым точным кадром, если она построена
+    ui->statisticsLabel->setText(tr("No data"));
+
+    if (fileData->size() == 0) {
+        ui->actionExport->setEnabled(false);
+        ui->centralWidget->clearPlot();
+        QMessageBox::warning(this, tr("Open"), tr("No points loaded\n") + fileData->error.c_str());
+        return;
+    }
     ui->centralWidget->renderNewFileData();
 }
 
+void MainWindow::showFileInfo()
+{
+    msgBox->setText(fileInfo + createMsgAboutMemory(thread.memoryUsage()));
+    msgBox->show();
+}
+
+void MainWindow::startLiveSource(const QString &socketPath, size_t capacity, int frameRate)
+{
+    // Память занимают кольцевой буфер и его копия в RenderThread
+    const size_t capacityLimit = memoryLimit / (2 * sizeof(DataLoader::Point));
+    if (memoryLimit != 0 && capacity > capacityLimit) {
+        QMessageBox::warning(this, tr("Live source"), tr("Capacity is reduced to %1 points by the memory limit").arg(capacityLimit));
+        capacity = capacityLimit;
+    }
+
+    liveBuffer.reset(new LiveBuffer(capacity));
+    liveSource.reset(new LiveSource(*liveBuffer, socketPath.toStdString()));
+    connect(liveSource.get(), &LiveSource::errorOccurred, this, [this](const QString &error){
+        QMessageBox::warning(this, tr("Live source"), error);
+    });
+
+    ui->actionOpen->setEnabled(false);
+    ui->actionExport->setEnabled(false);
+    setWindowTitle(tr("Live: %1").arg(socketPath.isEmpty() ? "stdin" : socketPath));
+
+    thread.setLiveBuffer(liveBuffer.get(), frameRate);
+    liveSource->start();
+    ui->centralWidget->renderNewFileData();
+}
+
+void MainWindow::recordTrace(bool enabled)
+{
+    if (!enabled) {
+        ui->centralWidget->stopTraceRecording();
+        return;
+    }
+
+    static QString lastTraceFile = QStandardPaths::writableLocation(QStandardPaths::HomeLocation);
+
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Record trace"),
+                                                    lastTraceFile, "*.trace;;All files(*)");
+
+    if (fileName.isNull() || !ui->centralWidget->startTraceRecording(fileName.toStdString())) {
+        ui->actionRecord_trace->setChecked(false);
+        return;
+    }
+
+    lastTraceFile = QFileInfo(fileName).path();
+}
+
+void MainWindow::updateStatistics(const RangeStatistics::Result &statistics)
+{
+    QString text;
+    text += tr("Points: %1\n").arg(statistics.points);
+    text += tr("Mean: %1\n").arg(statistics.mean);
+    text += tr("RMS: %1\n").arg(statistics.rms);
+    text += tr("Std. deviation: %1\n").arg(statistics.deviation);
+    text += tr("Min: %1\n").arg(statistics.min);
+    text += tr("Max: %1\n").arg(statistics.max);
+    text += tr("5%: ~%1\n").arg(statistics.p5);
+    text += tr("Median: ~%1\n").arg(statistics.median);
+    text += tr("95%: ~%1\n").arg(statistics.p95);
+    // Интервалы гистограмм строятся при загрузке по минимуму и максимуму всего файла
+    text += tr("Percentiles use %1 bins over the whole file range\nand get coarse when zoomed in").arg(RangeStatistics::HistogramBins);
+
+    ui->statisticsLabel->setText(text);
+}
+
+void MainWindow::exportData()
+{
+    if (dataExporting->isRunning()) {
+        QMessageBox::information(this, tr("Export"), tr("Previous export is still running"));
+        return;
+    }
+
+    const QStringList modes = { tr("Visible range"), tr("Whole file, min/max decimated"), tr("Whole file, LTTB decimated") };
+    bool ok;
+    QString mode = QInputDialog::getItem(this, tr("Export"), tr("Data:"), modes, 0, false, &ok);
+    if (!ok)
+        return;
+
+    auto fileData = thread.fileData();
+    exportedFileData = fileData;
+    DataExporter::Settings settings = {0, fileData->size(), DataExporter::Decimation::None, 0, DataExporter::Format::Text};
+    if (mode == modes[0]) {
+        thread.shownRange(settings.start, settings.end);
+    } else {
+        settings.decimation = (mode == modes[1]) ? DataExporter::Decimation::MinMax : DataExporter::Decimation::Lttb;
+        int points = QInputDialog::getInt(this, tr("Export"), tr("Points:"), 10000, 3, std::numeric_limits<int>::max(), 1, &ok);
+        if (!ok)
+            return;
+        settings.targetPoints = static_cast<size_t>(points);
+    }
+
+    static QString lastExportFile = QStandardPaths::writableLocation(QStandardPaths::HomeLocation);
+
+    QString selectedFilter;
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Export"), lastExportFile,
+                                                    "*.plot;;*.bin", &selectedFilter);
+    if (fileName.isNull())
+        return;
+
+    lastExportFile = QFileInfo(fileName).path();
+    if (fileName.endsWith(".bin") || selectedFilter == "*.bin")
+        settings.format = DataExporter::Format::Binary;
+
+    dataExporting->setFuture( QtConcurrent::run([fileData, name = fileName.toStdString(), settings](){
+        return DataExporter::exportData(*fileData, name, settings);
+    }) );
+}
+
+void MainWindow::exported()
+{
+    auto error = dataExporting->result();
+    if (!error.empty())
+        QMessageBox::warning(this, tr("Export"), error.c_str());
+}
+
 QString MainWindow::createMsgAboutFileLoad(DataLoader::FileData &fileData)
 {
     QString msg("File info:\n");
     msg += "Loaded ";
-    msg += std::to_string(fileData.points.size()).c_str();
+    msg += std::to_string(fileData.size()).c_str();
     msg += " points\n";
     if (fileData.header.empty())
         msg += "File has't contain any info\n";
@@ -84,9 +248,36 @@ QString MainWindow::createMsgAboutFileLoad(DataLoader::FileData &fileData)
         msg += fileData.error.c_str();
     }
 
+    msg += "Peak memory during load: " + formatBytes(fileData.peakLoadMemory) + "\n";
+
     return msg;
 }
 
+QString MainWindow::createMsgAboutMemory(const RenderThread::MemoryUsage &memory)
+{
+    const auto &fileData = memory.fileData;
+
+    QString msg("\nMemory:\n");
+    msg += "Points: " + formatBytes(fileData.points) + "\n";
+    msg += "Compressed points: " + formatBytes(fileData.compressed) + "\n";
+    msg += "Statistics: " + formatBytes(fileData.statistics) + "\n";
+    msg += "Header and errors: " + formatBytes(fileData.text) + "\n";
+    msg += "Summary levels: " + formatBytes(memory.summary) + "\n";
+    msg += "Last frame: " + formatBytes(memory.lastFrame) + "\n";
+    msg += "Frame buffers: " + formatBytes(memory.frame) + " (peak " + formatBytes(memory.peakFrame) + ")\n";
+    msg += "Total: " + formatBytes(fileData.total() + memory.summary + memory.lastFrame + memory.frame) + "\n";
+    if (fileData.mapped != 0)
+        msg += "Mapped file (not counted): " + formatBytes(fileData.mapped) + "\n";
+    msg += "Limit: " + (memoryLimit != 0 ? formatBytes(memoryLimit) : QString("none")) + "\n";
+
+    return msg;
+}
+
+QString MainWindow::formatBytes(size_t bytes)
+{
+    return QString::number(bytes / 1048576.0, 'f', 1) + " MB";
+}
+
 std::vector<DataLoader::Point> MainWindow::calcTestPoints(size_t quan)
 {
     double period = 60*3.14;
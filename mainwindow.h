@@ -5,7 +5,11 @@
 #include <QtConcurrent>
 #include <QMessageBox>
 
+#include <memory>
+
 #include "dataloader.h"
+#include "livebuffer.h"
+#include "livesource.h"
 #include "renderthread.h"
 
 namespace Ui {
@@ -17,8 +21,18 @@ class MainWindow;
  *
  * Функционал:
  *  1. Настраивает связи между всеми классами приложения (механизм сигнал-слот Qt)
- *  2. Выполняет чтение данных из файла в отделном потоке с помощью QFuture (функция open())
+ *  2. Выполняет чтение данных из файла в отделном потоке с помощью QFuture (функция open()),
+ *     при включенном File/Compress in memory там же сжимает точки (DataLoader::compressPoints());
+ *     там же строится статистика для панели Statistics (DataLoader::buildStatistics())
  *  3. Запускает отрисовку графика (функция finished())
+ *  4. Включает и выключает запись трассы запросов отрисовки (функция recordTrace())
+ *  5. Запускает потоковый режим: чтение данных из stdin или UNIX-сокета (функция startLiveSource())
+ *  6. Отображает статистику видимого диапазона на панели Statistics (функция updateStatistics())
+ *  7. Экспортирует видимый диапазон или прореженный файл в отдельном потоке (функция exportData()),
+ *     поток экспорта держит свой указатель на данные, поэтому загрузка нового файла его не ждет
+ *  8. Ограничивает память загружаемых данных (setMemoryLimit()) и показывает в File info память данных
+ *     и буферов отрисовки (функция showFileInfo()); загруженные данные передаются в RenderThread без копирования,
+ *     предыдущий файл освобождается до начала загрузки
  */
 class MainWindow : public QMainWindow
 {
@@ -28,18 +42,35 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    void startLiveSource(const QString &socketPath, size_t capacity, int frameRate);
+    void setMemoryLimit(size_t bytes) { memoryLimit = bytes; }
+
 private slots:
     void open();
     void finished();
+    void showFileInfo();
+    void recordTrace(bool enabled);
+    void updateStatistics(const RangeStatistics::Result &statistics);
+    void exportData();
+    void exported();
 
 private:
     Ui::MainWindow *ui;
+    // Объявлены до thread, чтобы при удалении окна поток отрисовки был остановлен первым
+    std::unique_ptr<LiveBuffer> liveBuffer;
+    std::unique_ptr<LiveSource> liveSource;
     RenderThread thread;
     QMessageBox *msgBox;
+    QString fileInfo;
+    size_t memoryLimit = DataLoader::defaultMemoryLimit();
 
-    QFutureWatcher<DataLoader::FileData> *fileDataLoading;
+    QFutureWatcher<std::shared_ptr<DataLoader::FileData>> *fileDataLoading;
+    QFutureWatcher<std::string> *dataExporting;
+    std::weak_ptr<const DataLoader::FileData> exportedFileData;
 
     QString createMsgAboutFileLoad(DataLoader::FileData &fileData);
+    QString createMsgAboutMemory(const RenderThread::MemoryUsage &memory);
+    QString formatBytes(size_t bytes);
     std::vector<DataLoader::Point> calcTestPoints(size_t quan);
 };
 
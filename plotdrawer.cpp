@@ -10,6 +10,8 @@
 #include <cmath>
 #include <limits>
 
+#include "interactiontrace.h"
+
 const double ZoomInFactor = 0.8;
 const double ZoomOutFactor = 1.0 / ZoomInFactor;
 const int ScrollStep = 20;
@@ -25,7 +27,44 @@ PlotDrawer::PlotDrawer(QWidget *parent) : QWidget(parent)
 void PlotDrawer::renderNewFileData()
 {
     curScale = maxScale;
-    emit render(pixmapOffset, curScale, size());
+    requestRender(pixmapOffset, curScale, size());
+}
+
+// Вместо графика снова выводится подсказка, например если файл не загружен
+void PlotDrawer::clearPlot()
+{
+    pixmap = QPixmap();
+    update();
+}
+
+bool PlotDrawer::startTraceRecording(const std::string &fileName)
+{
+    stopTraceRecording();
+
+    traceStream.open(fileName, std::ios::out | std::ios::trunc);
+    if ( !traceStream )
+        return false;
+
+    InteractionTrace::writeHeader(traceStream);
+    traceTimer.start();
+    return true;
+}
+
+void PlotDrawer::stopTraceRecording()
+{
+    if (traceStream.is_open())
+        traceStream.close();
+}
+
+void PlotDrawer::requestRender(int pixmapOffset, double scaleFactor, QSize resultSize)
+{
+    if (traceStream.is_open()) {
+        double time = traceTimer.nsecsElapsed() / 1e6;
+        InteractionTrace::writeRequest(traceStream, { time, pixmapOffset, scaleFactor,
+                                                      resultSize.width(), resultSize.height() });
+    }
+
+    emit render(pixmapOffset, scaleFactor, resultSize);
 }
 
 void PlotDrawer::paintEvent(QPaintEvent * /* event */)
@@ -78,7 +117,7 @@ void PlotDrawer::drawScaledPixmap(QPainter &painter)
 void PlotDrawer::resizeEvent(QResizeEvent * /* event */)
 {
     update();
-    emit render(pixmapOffset, curScale, size());
+    requestRender(pixmapOffset, curScale, size());
 }
 
 void PlotDrawer::keyPressEvent(QKeyEvent *event)
@@ -145,13 +184,13 @@ void PlotDrawer::zoom(double zoomFactor)
         curScale = maxScale;
 
     update();
-    emit render(pixmapOffset, curScale, size());
+    requestRender(pixmapOffset, curScale, size());
 }
 
 void PlotDrawer::scroll(int pointsOffset)
 {
     update();
-    emit render(pointsOffset, curScale, size());
+    requestRender(pointsOffset, curScale, size());
 }
 
 void PlotDrawer::updatePlot(const QPixmap &plot, double scaleFactor, size_t newShownPoints)
@@ -172,5 +211,10 @@ void PlotDrawer::updateMinMaxScale(double min, double max)
 {
     minScale = min;
     maxScale = max;
+
+    if (curScale < minScale)
+        curScale = minScale;
+    if (curScale > maxScale)
+        curScale = maxScale;
 }
 
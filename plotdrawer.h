@@ -3,6 +3,9 @@
 
 #include <QWidget>
 #include <QPixmap>
+#include <QElapsedTimer>
+#include <fstream>
+#include <string>
 
 /*
  * Класс для отображения графика
@@ -13,6 +16,8 @@
  *  3. Формирует данные (координаты, размер и масшаб), которые необходимы для отрисовки графика и
  *     отправляет их в RenderThread для отрисовки;
  *  4. Пока новые данные расчитываются, масшабирует или передвигает текующий QPixmap;
+ *  5. При включенной записи трассы сохраняет каждый запрос отрисовки с отметкой времени
+ *     (формат InteractionTrace) для последующего воспроизведения в PlotReplay.
  */
 class PlotDrawer : public QWidget
 {
@@ -20,6 +25,10 @@ class PlotDrawer : public QWidget
 public:
     explicit PlotDrawer(QWidget *parent = nullptr);
     void renderNewFileData();
+    void clearPlot();
+
+    bool startTraceRecording(const std::string &fileName);
+    void stopTraceRecording();
 
 protected:
     void paintEvent(QPaintEvent *event) override;
@@ -42,6 +51,7 @@ public slots:
 private:
     void zoom(double zoomFactor);
     void scroll(int pointsOffset);
+    void requestRender(int pixmapOffset, double scaleFactor, QSize resultSize);
 
     void drawHelpMessage(QPainter &painter);
     void drawPixmap(QPainter &painter);
@@ -57,6 +67,9 @@ private:
 
     double minScale = 1.0;
     double maxScale = 10.0;
+
+    std::ofstream traceStream;
+    QElapsedTimer traceTimer;
 };
 
 #endif // PLOTDRAWER_H
@@ -0,0 +1,127 @@
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "dataloader.h"
+#include "interactiontrace.h"
+#include "renderthread.h"
+
+/*
+ * Воспроизведение трассы запросов отрисовки без окна
+ *
+ * Использование: PlotReplay <файл .plot или .desc> <файл трассы> [ограничение памяти, МБ]
+ *  1. Запросы из трассы (записанной PlotDrawer) подаются в RenderThread с исходными интервалами;
+ *  2. Задержка запроса - время от вызова render() до получения кадра, который его учитывает;
+ *     отдельно выводятся задержки первого кадра (грубого, если он был) и точного кадра;
+ *  3. Пропущенный кадр - запрос, точный кадр которого не был выведен из-за следующего запроса;
+ *  4. После воспроизведения выводится память данных и буферов отрисовки (RenderThread::memoryUsage()).
+ */
+
+double percentile(const std::vector<double> &sorted, double p)
+{
+    auto rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[rank > 0 ? rank-1 : 0];
+}
+
+int main(int argc, char *argv[])
+{
+    // QPixmap требует QGuiApplication, поэтому без дисплея используется платформа offscreen
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication a(argc, argv);
+
+    if (argc != 3 && argc != 4) {
+        std::cerr << "Usage: PlotReplay <file.plot> <file.trace> [memory limit, MB]\n";
+        return 1;
+    }
+
+    const size_t memoryLimit = (argc == 4) ? std::strtoull(argv[3], nullptr, 10) << 20 : DataLoader::defaultMemoryLimit();
+    auto fileData = DataLoader::loadMeasurementData(argv[1], memoryLimit);
+    std::cerr << fileData.error;
+    if (fileData.size() == 0) {
+        std::cerr << "No points loaded\n";
+        return 1;
+    }
+
+    auto traceData = InteractionTrace::loadTrace(argv[2]);
+    std::cerr << traceData.error;
+    const auto &requests = traceData.requests;
+    if (requests.empty()) {
+        std::cerr << "Trace has no requests\n";
+        return 1;
+    }
+
+    RenderThread thread;
+    thread.setPlotFileData(std::make_shared<DataLoader::FileData>(std::move(fileData)));
+
+    QElapsedTimer timer;
+    std::vector<qint64> sentAt(requests.size());
+    std::vector<double> firstLatencies, exactLatencies;
+    quint64 lastFirstServed = 0;
+    quint64 lastServed = 0;
+    quint64 dropped = 0;
+
+    // Номера запросов в RenderThread начинаются с 1 и совпадают с порядком запросов в трассе
+    QObject::connect(&thread, &RenderThread::requestServed, &a, [&](quint64 requestNumber, bool exact){
+        const double latency = (timer.nsecsElapsed() - sentAt[requestNumber-1]) / 1e6;
+        if (requestNumber > lastFirstServed) {
+            firstLatencies.push_back(latency);
+            lastFirstServed = requestNumber;
+        }
+
+        if (!exact || requestNumber <= lastServed)
+            return;
+
+        dropped += requestNumber - lastServed - 1;
+        exactLatencies.push_back(latency);
+        lastServed = requestNumber;
+
+        if (lastServed == requests.size())
+            a.quit();
+    });
+
+    timer.start();
+    for (size_t i = 0; i < requests.size(); ++i) {
+        auto delay = static_cast<int>(requests[i].time - requests.front().time);
+        QTimer::singleShot(delay, Qt::PreciseTimer, &a, [&, i](){
+            const auto &request = requests[i];
+            sentAt[i] = timer.nsecsElapsed();
+            thread.render(request.pixmapOffset, request.scaleFactor, QSize(request.width, request.height));
+        });
+    }
+
+    a.exec();
+
+    std::sort(firstLatencies.begin(), firstLatencies.end());
+    std::sort(exactLatencies.begin(), exactLatencies.end());
+    std::cout << std::fixed << std::setprecision(3)
+              << "Requests: " << requests.size() << "\n"
+              << "Frames: " << exactLatencies.size() << "\n"
+              << "Dropped frames: " << dropped << "\n"
+              << "First frame latency p50, ms: " << percentile(firstLatencies, 0.50) << "\n"
+              << "First frame latency p95, ms: " << percentile(firstLatencies, 0.95) << "\n"
+              << "First frame latency p99, ms: " << percentile(firstLatencies, 0.99) << "\n"
+              << "Exact frame latency p50, ms: " << percentile(exactLatencies, 0.50) << "\n"
+              << "Exact frame latency p95, ms: " << percentile(exactLatencies, 0.95) << "\n"
+              << "Exact frame latency p99, ms: " << percentile(exactLatencies, 0.99) << "\n";
+
+    const auto memory = thread.memoryUsage();
+    std::cout << "Memory, bytes:\n"
+              << "  points: " << memory.fileData.points << "\n"
+              << "  compressed points: " << memory.fileData.compressed << "\n"
+              << "  header and errors: " << memory.fileData.text << "\n"
+              << "  mapped file: " << memory.fileData.mapped << "\n"
+              << "  summary levels: " << memory.summary << "\n"
+              << "  last frame: " << memory.lastFrame << "\n"
+              << "  peak frame buffers: " << memory.peakFrame << "\n"
+              << "  peak during load: " << thread.fileData()->peakLoadMemory << "\n";
+
+    return 0;
+}
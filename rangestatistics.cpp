@@ -0,0 +1,55 @@
+#include "rangestatistics.h"
+
+void RangeStatistics::Sum::add(double value)
+{
+    const double total = sum + value;
+    if (std::abs(sum) >= std::abs(value))
+        compensation += (sum - total) + value;
+    else
+        compensation += (value - total) + sum;
+    sum = total;
+}
+
+// NaN и значения ниже minValue попадают в первый интервал, +inf и значения выше maxValue - в последний;
+// проверки выполняются до приведения к size_t, которое для NaN и inf не определено
+size_t RangeStatistics::bin(double value) const
+{
+    if (!(binWidth > 0.0))
+        return 0;
+
+    const double position = (value - minValue) / binWidth;
+    if (!(position > 0.0))
+        return 0;
+    if (position >= static_cast<double>(HistogramBins))
+        return HistogramBins - 1;
+
+    return static_cast<size_t>(position);
+}
+
+// Значение внутри найденного интервала гистограммы интерполируется линейно
+double RangeStatistics::percentile(const Histogram &histogram, size_t quan, double p) const
+{
+    const double rank = p * static_cast<double>(quan);
+    double counted = 0.0;
+    for (size_t i = 0; i < HistogramBins; ++i) {
+        const double binQuan = static_cast<double>(histogram[i]);
+        if (binQuan > 0.0 && counted + binQuan >= rank)
+            return minValue + binWidth * (static_cast<double>(i) + (rank - counted) / binQuan);
+        counted += binQuan;
+    }
+
+    return minValue + binWidth * HistogramBins;
+}
+
+size_t RangeStatistics::memoryUsage() const
+{
+    return sizeof(*this) + (prefixSums.capacity() + prefixSquares.capacity()) * sizeof(Sum)
+            + prefixHistograms.capacity() * sizeof(Histogram);
+}
+
+// Память, которую займет статистика quan точек (совпадает с memoryUsage() после построения)
+size_t RangeStatistics::estimateMemoryUsage(size_t quan)
+{
+    return sizeof(RangeStatistics) + 2 * ((quan + SumBlockSize - 1) / SumBlockSize + 1) * sizeof(Sum)
+            + ((quan + HistogramBlockSize - 1) / HistogramBlockSize + 1) * sizeof(Histogram);
+}
@@ -0,0 +1,172 @@
+#ifndef RANGESTATISTICS_H
+#define RANGESTATISTICS_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Статистика произвольного диапазона точек
+ *
+ * Функционал
+ *  1. При загрузке один раз строит префиксные суммы значений и их квадратов по блокам из
+ *     SumBlockSize точек (суммирование с компенсацией Neumaier);
+ *  2. Для уменьшения потери точности при вычислении дисперсии суммируются отклонения от shift;
+ *  3. Для приближенных перцентилей хранит префиксные гистограммы по блокам из HistogramBlockSize точек,
+ *     гистограмма диапазона получается разностью двух префиксов;
+ *  4. Стоимость calc() не зависит от размера диапазона: неполные блоки на краях досчитываются по точкам.
+ */
+class RangeStatistics
+{
+public:
+    static const size_t SumBlockSize = 1024;
+    static const size_t HistogramBlockSize = 65536;
+    static const size_t HistogramBins = 256;
+
+    struct Result {
+        size_t points = 0;
+        double mean = 0.0;
+        double rms = 0.0;
+        double deviation = 0.0;
+        double min = 0.0;
+        double max = 0.0;
+        double p5 = 0.0;
+        double median = 0.0;
+        double p95 = 0.0;
+    };
+
+    template<typename Values>
+    RangeStatistics(const Values &values, size_t quan, double minValue, double maxValue);
+
+    template<typename Values>
+    Result calc(const Values &values, size_t start, size_t end) const;
+
+    size_t memoryUsage() const;
+    static size_t estimateMemoryUsage(size_t quan);
+
+private:
+    struct Sum {
+        void add(double value);
+        Sum operator-(const Sum &other) const { return {sum - other.sum, compensation - other.compensation}; }
+        double value() const { return sum + compensation; }
+
+        double sum;
+        double compensation;
+    };
+
+    typedef std::array<uint64_t, HistogramBins> Histogram;
+
+    size_t bin(double value) const;
+    double percentile(const Histogram &histogram, size_t quan, double p) const;
+
+    double shift;
+    double minValue;
+    double binWidth;
+    std::vector<Sum> prefixSums;
+    std::vector<Sum> prefixSquares;
+    std::vector<Histogram> prefixHistograms;
+};
+
+template<typename Values>
+RangeStatistics::RangeStatistics(const Values &values, size_t quan, double minValue, double maxValue) :
+    shift(quan > 0 ? values[0] : 0.0),
+    minValue(minValue),
+    binWidth((maxValue - minValue) / HistogramBins)
+{
+    Sum sum = {0.0, 0.0}, squares = {0.0, 0.0};
+    Histogram histogram = {};
+
+    // По префиксу на начало каждого блока и один на конец диапазона
+    prefixSums.reserve((quan + SumBlockSize - 1) / SumBlockSize + 1);
+    prefixSquares.reserve((quan + SumBlockSize - 1) / SumBlockSize + 1);
+    prefixHistograms.reserve((quan + HistogramBlockSize - 1) / HistogramBlockSize + 1);
+
+    for (size_t i = 0; i < quan; ++i) {
+        if (i % SumBlockSize == 0) {
+            prefixSums.push_back(sum);
+            prefixSquares.push_back(squares);
+        }
+        if (i % HistogramBlockSize == 0)
+            prefixHistograms.push_back(histogram);
+
+        const double value = values[i];
+        sum.add(value - shift);
+        squares.add((value - shift) * (value - shift));
+        ++histogram[bin(value)];
+    }
+
+    prefixSums.push_back(sum);
+    prefixSquares.push_back(squares);
+    prefixHistograms.push_back(histogram);
+}
+
+template<typename Values>
+RangeStatistics::Result RangeStatistics::calc(const Values &values, size_t start, size_t end) const
+{
+    Result result;
+    result.points = end - start;
+    if (start >= end)
+        return result;
+
+    Sum sum = {0.0, 0.0}, squares = {0.0, 0.0};
+    Histogram histogram = {};
+
+    auto addPoints = [&](size_t from, size_t to, bool toHistogram, bool toSums){
+        for (size_t i = from; i < to; ++i) {
+            const double value = values[i];
+            if (toSums) {
+                sum.add(value - shift);
+                squares.add((value - shift) * (value - shift));
+            }
+            if (toHistogram)
+                ++histogram[bin(value)];
+        }
+    };
+
+    // Полные блоки берутся из префиксов, края диапазона досчитываются по точкам
+    const size_t firstSumBlock = (start + SumBlockSize - 1) / SumBlockSize;
+    const size_t lastSumBlock = end / SumBlockSize;
+    if (firstSumBlock < lastSumBlock) {
+        const Sum blocksSum = prefixSums[lastSumBlock] - prefixSums[firstSumBlock];
+        const Sum blocksSquares = prefixSquares[lastSumBlock] - prefixSquares[firstSumBlock];
+        addPoints(start, firstSumBlock * SumBlockSize, false, true);
+        addPoints(lastSumBlock * SumBlockSize, end, false, true);
+        sum.add(blocksSum.sum);
+        sum.add(blocksSum.compensation);
+        squares.add(blocksSquares.sum);
+        squares.add(blocksSquares.compensation);
+    } else {
+        addPoints(start, end, false, true);
+    }
+
+    const size_t firstHistogramBlock = (start + HistogramBlockSize - 1) / HistogramBlockSize;
+    const size_t lastHistogramBlock = end / HistogramBlockSize;
+    if (firstHistogramBlock < lastHistogramBlock) {
+        const auto &from = prefixHistograms[firstHistogramBlock];
+        const auto &to = prefixHistograms[lastHistogramBlock];
+        for (size_t i = 0; i < HistogramBins; ++i)
+            histogram[i] = to[i] - from[i];
+        addPoints(start, firstHistogramBlock * HistogramBlockSize, true, false);
+        addPoints(lastHistogramBlock * HistogramBlockSize, end, true, false);
+    } else {
+        addPoints(start, end, true, false);
+    }
+
+    const double n = static_cast<double>(result.points);
+    const double meanOffset = sum.value() / n;
+    const double meanSquareOffset = squares.value() / n;
+    result.mean = shift + meanOffset;
+    result.deviation = std::sqrt(std::max(meanSquareOffset - meanOffset * meanOffset, 0.0));
+    result.rms = std::sqrt(result.deviation * result.deviation + result.mean * result.mean);
+
+    result.p5 = percentile(histogram, result.points, 0.05);
+    result.median = percentile(histogram, result.points, 0.50);
+    result.p95 = percentile(histogram, result.points, 0.95);
+
+    return result;
+}
+
+#endif // RANGESTATISTICS_H
@@ -3,15 +3,87 @@
 #include <algorithm>
 #include <QPixmap>
 #include <QPainter>
+#include <QImage>
+#include <QtConcurrent>
 
 #include <string>
 #include <sstream>
 #include <cmath>
+#include <cstdlib>
 #include <limits>
+#include <numeric>
 
-RenderThread::RenderThread(QObject *parent) : QThread(parent)
+namespace {
+
+const size_t SummaryBlockSize = 1024;
+const size_t SummaryLevelRatio = 32;
+const size_t ProgressiveMinPoints = 1 << 22;
+const size_t CancelCheckColumns = 64;
+
+size_t pixmapBytes(const QSize &size)
 {
+    return static_cast<size_t>(size.width()) * static_cast<size_t>(size.height()) * sizeof(QRgb);
+}
 
+size_t pathBytes(const QPainterPath &path)
+{
+    return static_cast<size_t>(path.elementCount()) * sizeof(QPainterPath::Element);
+}
+
+// Сравнение выполняется в исходном типе отсчетов, в double преобразуется только результат
+template<typename Values>
+void findMinMax(const Values &values, size_t start, size_t end, double &min, double &max)
+{
+    auto minValue = values[start];
+    auto maxValue = values[start];
+    for (size_t i = start + 1; i < end; ++i) {
+        auto value = values[i];
+        if (value < minValue)
+            minValue = value;
+        if (value > maxValue)
+            maxValue = value;
+    }
+
+    min = minValue;
+    max = maxValue;
+}
+
+// Блоки, целиком попадающие в диапазон, учитываются по заголовку без декодирования
+void findMinMax(const DataLoader::CompressedValues &values, size_t start, size_t end, double &min, double &max)
+{
+    using DataLoader::CompressedPoints;
+
+    // Начальные значения не берутся из values[start], иначе декодировался бы и полностью покрытый блок
+    min = std::numeric_limits<double>::infinity();
+    max = -std::numeric_limits<double>::infinity();
+    for (size_t i = start; i < end; ) {
+        const size_t index = i / CompressedPoints::BlockSize;
+        const size_t blockEnd = index * CompressedPoints::BlockSize + values.points->blockLength(index);
+        if (i % CompressedPoints::BlockSize == 0 && blockEnd <= end) {
+            min = std::min(min, values.points->block(index).min);
+            max = std::max(max, values.points->block(index).max);
+            i = blockEnd;
+            continue;
+        }
+
+        for (const size_t partEnd = std::min(blockEnd, end); i < partEnd; ++i) {
+            min = std::min(min, values[i]);
+            max = std::max(max, values[i]);
+        }
+    }
+}
+
+}
+
+template<typename Visitor>
+void RenderThread::visitValues(Visitor visitor) const
+{
+    DataLoader::visitValues(*plotFileData, visitor);
+}
+
+RenderThread::RenderThread(QObject *parent) : QThread(parent)
+{
+    connect(&liveTimer, &QTimer::timeout, this, &RenderThread::requestLiveFrame);
 }
 
 RenderThread::~RenderThread()
@@ -21,13 +93,32 @@ RenderThread::~RenderThread()
 
 void RenderThread::render(int pixmapOffset, double scaleFactor, QSize resultSize)
 {
-    if (plotFileData.points.empty())
+    if (!liveBuffer && pointsQuan == 0)
         return;
 
     QMutexLocker locker(&mutex);
     exchData.pixmapOffset = pixmapOffset;
     exchData.scaleFactor  = scaleFactor;
     exchData.resultSize   = resultSize;
+    ++exchData.requestNumber;
+    restartRendering();
+}
+
+void RenderThread::setDensityMode(bool enabled)
+{
+    QMutexLocker locker(&mutex);
+    exchData.densityMode = enabled;
+
+    // Запрос, ожидающий обработки, сам подхватит новый режим
+    if (restart || (!liveBuffer && pointsQuan == 0))
+        return;
+
+    exchData.pixmapOffset = 0;
+    restartRendering();
+}
+
+void RenderThread::restartRendering()
+{
     restart = true;
 
     if (!isRunning()) {
@@ -37,13 +128,50 @@ void RenderThread::render(int pixmapOffset, double scaleFactor, QSize resultSize
     }
 }
 
-void RenderThread::setPlotFileData(DataLoader::FileData &plotFileData)
+// Данные разделяются с экспортом (MainWindow::exportData()), поэтому передаются через shared_ptr
+void RenderThread::setPlotFileData(std::shared_ptr<DataLoader::FileData> plotFileData)
 {
     stopThread();
+    liveTimer.stop();
+    liveBuffer = nullptr;
     this->plotFileData = std::move(plotFileData);
     setupPlotData();
 }
 
+void RenderThread::setLiveBuffer(LiveBuffer *buffer, int frameRate)
+{
+    stopThread();
+    abort = false;
+    liveBuffer = buffer;
+    liveReceivedPoints = 0;
+
+    // Память под копию буфера выделяется один раз, далее copyTo() ее только переиспользует
+    plotFileData = std::make_shared<DataLoader::FileData>();
+    plotFileData->points.reserve(buffer->capacity());
+    summaryLevels.clear();
+    startPoint = endPoint = pointsQuan = 0;
+    lastFrame = QPixmap();
+    memory = MemoryUsage();
+
+    // При frameRate > 1000 интервал 0 мс занял бы цикл событий целиком
+    liveTimer.start(std::max(1, 1000 / frameRate));
+}
+
+void RenderThread::requestLiveFrame()
+{
+    auto received = liveBuffer->receivedPoints();
+    if (received == liveReceivedPoints)
+        return;
+    liveReceivedPoints = received;
+
+    QMutexLocker locker(&mutex);
+    // Размер графика еще не известен: PlotDrawer не отправил ни одного запроса
+    if (!exchData.resultSize.isValid())
+        return;
+
+    restartRendering();
+}
+
 void RenderThread::stopThread()
 {
     mutex.lock();
@@ -58,9 +186,14 @@ void RenderThread::setupPlotData()
 {
     abort = false;
     startPoint = 0;
-    endPoint = this->plotFileData.points.size();
+    endPoint = plotFileData->size();
     pointsQuan = endPoint;
-    findMinMaxValues();
+    shownStart = 0;
+    shownEnd = endPoint;
+    lastFrame = QPixmap();
+    summaryLevels.clear();
+    memory = MemoryUsage();
+    memory.fileData = DataLoader::memoryUsage(*plotFileData);
 
     double maxScale = pointsQuan / minShownPoints;
     safeData.scaleFactor = maxScale;
@@ -75,14 +208,13 @@ void RenderThread::run()
         restart = false;
         mutex.unlock();
 
-        calcStartAndEndPoints();
-        std::vector<QPoint> plotPoints = calcPlottedPoints();
-        QPixmap plot;
-        if (!plotPoints.empty())
-            plot = drawPixmap(plotPoints);
+        if (!liveBuffer && summaryLevels.empty())
+            buildSummary();
 
-        auto pointsQuan = endPoint-startPoint;
-        emit plotRendered(plot, safeData.scaleFactor, pointsQuan);
+        frameMemory = 0;
+        if (!liveBuffer || updateLiveData())
+            renderFrame();
+        updateMemoryUsage();
 
         QMutexLocker locker(&mutex);
         if (!restart)
@@ -93,9 +225,127 @@ void RenderThread::run()
     }
 }
 
+void RenderThread::renderFrame()
+{
+    calcStartAndEndPoints();
+    frameCancelled = false;
+
+    // Потоковый режим не прерывается, иначе при частых обновлениях кадры не будут выводиться;
+    // дорисовка при сдвиге не прерывается, так как ее стоимость ограничена величиной сдвига,
+    // а прерванный сдвиг сбросил бы lastFrame и все последующие кадры рисовались бы целиком
+    const bool scroll = canScrollLastFrame();
+    frameCancellable = !liveBuffer && !scroll;
+
+    QPixmap plot;
+    if (scroll) {
+        plot = scrollLastFrame();
+    } else {
+        if (isCoarseFrameNeeded())
+            emitFrame(drawCoarsePixmap(), false);
+        plot = drawPixmap();
+    }
+
+    // Точный кадр прерван новым запросом: предыдущий кадр уже не соответствует startPoint
+    if (frameCancelled) {
+        lastFrame = QPixmap();
+        return;
+    }
+
+    lastFrame = plot;
+    lastFrameSize = safeData.resultSize;
+    lastFramePoints = displayedPoints;
+    lastFrameDensityMode = safeData.densityMode;
+    emitFrame(plot, true);
+
+    if (plotFileData->statistics)
+        emitStatistics();
+}
+
+void RenderThread::emitStatistics()
+{
+    RangeStatistics::Result statistics;
+    visitValues([&](const auto &values){ statistics = plotFileData->statistics->calc(values, startPoint, endPoint); });
+    findRangeMinMax(startPoint, endPoint, statistics.min, statistics.max);
+
+    emit statisticsUpdated(statistics);
+}
+
+void RenderThread::emitFrame(const QPixmap &plot, bool exact)
+{
+    mutex.lock();
+    shownStart = startPoint;
+    shownEnd = endPoint;
+    mutex.unlock();
+
+    auto pointsQuan = endPoint-startPoint;
+    emit plotRendered(plot, safeData.scaleFactor, pointsQuan);
+    emit requestServed(safeData.requestNumber, exact);
+}
+
+void RenderThread::updateMemoryUsage()
+{
+    size_t summary = 0;
+    for (const auto &level : summaryLevels)
+        summary += level.capacity() * sizeof(MinMax);
+
+    QMutexLocker locker(&mutex);
+    memory.fileData = DataLoader::memoryUsage(*plotFileData);
+    memory.summary = summary;
+    memory.lastFrame = lastFrame.isNull() ? 0 : pixmapBytes(lastFrame.size());
+    memory.frame = frameMemory;
+    memory.peakFrame = std::max(memory.peakFrame, frameMemory);
+}
+
+RenderThread::MemoryUsage RenderThread::memoryUsage()
+{
+    QMutexLocker locker(&mutex);
+    return memory;
+}
+
+// Диапазон точек последнего выведенного кадра
+void RenderThread::shownRange(size_t &start, size_t &end)
+{
+    QMutexLocker locker(&mutex);
+    start = shownStart;
+    end = shownEnd;
+}
+
+bool RenderThread::isRestartRequested()
+{
+    QMutexLocker locker(&mutex);
+    return restart || abort;
+}
+
+// Копирует текущее содержимое LiveBuffer и настраивает отображение всех его точек
+bool RenderThread::updateLiveData()
+{
+    liveBuffer->copyTo(plotFileData->points, minValue, maxValue);
+    pointsQuan = plotFileData->points.size();
+    if (pointsQuan < minShownPoints)
+        return false;
+
+    if (!(maxValue > minValue)) {
+        minValue -= 1.0;
+        maxValue += 1.0;
+    }
+
+    startPoint = 0;
+    safeData.pixmapOffset = 0;
+    safeData.scaleFactor = static_cast<double>(pointsQuan / minShownPoints);
+    lastFrame = QPixmap();
+    emit scaleMinMaxUpdated(safeData.scaleFactor, safeData.scaleFactor);
+
+    return true;
+}
+
 void RenderThread::calcStartAndEndPoints()
 {
-    auto displayedPoints = static_cast<size_t>( minShownPoints * safeData.scaleFactor);
+    displayedPoints = static_cast<size_t>( minShownPoints * safeData.scaleFactor);
+    if (isDrawnByColumns()) {
+        calcFirstColumn();
+        return;
+    }
+
     auto pointsOffset = calcPointsOffset(displayedPoints);
 
     calcStartPoint(displayedPoints, pointsOffset);
@@ -128,6 +378,36 @@ void RenderThread::calcEndPoint(size_t displayedPoints)
         endPoint = pointsQuan;
 }
 
+bool RenderThread::isDrawnByColumns() const
+{
+    return displayedPoints >= 2 * static_cast<size_t>(safeData.resultSize.width());
+}
+
+void RenderThread::calcFirstColumn()
+{
+    const size_t width = static_cast<size_t>(safeData.resultSize.width());
+    const size_t columnsQuan = pointsQuan * width / displayedPoints;
+    const auto lastColumn = static_cast<ptrdiff_t>(columnsQuan > width ? columnsQuan - width : 0);
+
+    // Округление вверх, чтобы столбец предыдущего кадра того же масштаба восстановился точно
+    auto column = static_cast<ptrdiff_t>((startPoint * width + displayedPoints - 1) / displayedPoints);
+    auto newColumn = column - safeData.pixmapOffset;
+    if (newColumn < 0)
+        newColumn = 0;
+    if (newColumn > lastColumn)
+        newColumn = lastColumn;
+
+    columnsShift = column - newColumn;
+    firstColumn = static_cast<size_t>(newColumn);
+    startPoint = columnBegin(firstColumn);
+    endPoint = columnBegin(firstColumn + width);
+}
+
+size_t RenderThread::columnBegin(size_t column) const
+{
+    return column * displayedPoints / static_cast<size_t>(safeData.resultSize.width());
+}
+
 int RenderThread::calcPointsOffset(size_t displayedPoints)
 {
     if (displayedPoints == 0)
@@ -159,16 +439,114 @@ int RenderThread::convertToSigned(size_t displayedPoints)
     return displayed;
 }
 
-void RenderThread::findMinMaxValues()
+// Строит уровни минимумов и максимумов по блокам точек, верхний уровень содержит minValue и maxValue
+void RenderThread::buildSummary()
 {
-    if (plotFileData.points.empty())
+    if (pointsQuan == 0)
         return;
 
-    using DataLoader::Point;
-    auto minmax = std::minmax_element(plotFileData.points.cbegin(), plotFileData.points.cend(),
-                                      [](const Point &a, const Point &b){ return a.value < b.value; });
-    minValue = minmax.first->value;
-    maxValue = minmax.second->value;
+    std::vector<MinMax> level((pointsQuan + SummaryBlockSize - 1) / SummaryBlockSize);
+    visitValues([&](const auto &values){
+        for (size_t i = 0; i < level.size(); ++i) {
+            findMinMax(values, i * SummaryBlockSize, std::min((i+1) * SummaryBlockSize, pointsQuan),
+                       level[i].min, level[i].max);
+        }
+    });
+
+    while (level.size() > 1) {
+        std::vector<MinMax> upperLevel((level.size() + SummaryLevelRatio - 1) / SummaryLevelRatio);
+        for (size_t i = 0; i < level.size(); ++i) {
+            auto &upper = upperLevel[i / SummaryLevelRatio];
+            upper.min = (i % SummaryLevelRatio == 0) ? level[i].min : std::min(upper.min, level[i].min);
+            upper.max = (i % SummaryLevelRatio == 0) ? level[i].max : std::max(upper.max, level[i].max);
+        }
+        summaryLevels.push_back(std::move(level));
+        level = std::move(upperLevel);
+    }
+    summaryLevels.push_back(std::move(level));
+
+    minValue = summaryLevels.back().front().min;
+    maxValue = summaryLevels.back().front().max;
+}
+
+// Минимум и максимум диапазона: выровненные блоки берутся из самого грубого подходящего уровня
+// summaryLevels, точки проходятся только в неполных блоках нижнего уровня на краях диапазона
+void RenderThread::findRangeMinMax(size_t start, size_t end, double &min, double &max)
+{
+    min = std::numeric_limits<double>::infinity();
+    max = -std::numeric_limits<double>::infinity();
+
+    visitValues([&](const auto &values){
+        for (size_t i = start; i < end; ) {
+            size_t level = summaryLevels.size(), blockSize = SummaryBlockSize;
+            for (size_t l = 0, size = SummaryBlockSize; l < summaryLevels.size(); ++l, size *= SummaryLevelRatio) {
+                if (i % size != 0 || i + size > end)
+                    break;
+                level = l;
+                blockSize = size;
+            }
+
+            double partMin, partMax;
+            if (level < summaryLevels.size()) {
+                partMin = summaryLevels[level][i / blockSize].min;
+                partMax = summaryLevels[level][i / blockSize].max;
+                i += blockSize;
+            } else {
+                const size_t partEnd = std::min((i / SummaryBlockSize + 1) * SummaryBlockSize, end);
+                findMinMax(values, i, partEnd, partMin, partMax);
+                i = partEnd;
+            }
+
+            min = std::min(min, partMin);
+            max = std::max(max, partMax);
+        }
+    });
+}
+
+bool RenderThread::isCoarseFrameNeeded() const
+{
+    if (liveBuffer || summaryLevels.empty() || safeData.densityMode || !isDrawnByColumns())
+        return false;
+
+    const size_t columnPoints = displayedPoints / static_cast<size_t>(safeData.resultSize.width());
+    return displayedPoints >= ProgressiveMinPoints && columnPoints >= 2 * SummaryBlockSize;
+}
+
+// Быстрый предварительный кадр: столбец строится по самому грубому уровню, в котором на столбец
+// приходится не меньше двух блоков. Блоки на границах столбца учитываются целиком, поэтому
+// диапазон столбца может быть немного шире точного
+QPixmap RenderThread::drawCoarsePixmap()
+{
+    const size_t width = static_cast<size_t>(safeData.resultSize.width());
+    const size_t columnPoints = displayedPoints / width;
+
+    size_t level = 0, blockSize = SummaryBlockSize;
+    while (level + 1 < summaryLevels.size() && 2 * blockSize * SummaryLevelRatio <= columnPoints) {
+        ++level;
+        blockSize *= SummaryLevelRatio;
+    }
+    const auto &blocks = summaryLevels[level];
+
+    QPainterPath path;
+    for (size_t i = 0; i < width; ++i) {
+        const size_t first = columnBegin(firstColumn + i) / blockSize;
+        const size_t last  = (columnBegin(firstColumn + i + 1) - 1) / blockSize;
+
+        double min = blocks[first].min, max = blocks[first].max;
+        for (size_t block = first + 1; block <= last; ++block) {
+            min = std::min(min, blocks[block].min);
+            max = std::max(max, blocks[block].max);
+        }
+
+        path.moveTo(i, calcYPos(min));
+        path.lineTo(i, calcYPos(max));
+    }
+
+    QPixmap pix(safeData.resultSize.width(), safeData.resultSize.height());
+    pix.fill(Qt::white);
+    drawPath(pix, path);
+
+    return pix;
 }
 
 std::vector<QPoint> RenderThread::calcPlottedPoints()
@@ -180,47 +558,102 @@ std::vector<QPoint> RenderThread::calcPlottedPoints()
 
     auto plotPointsQuan = endPoint - startPoint;
     plotPoints.reserve(plotPointsQuan);
+    frameMemory += plotPoints.capacity() * sizeof(QPoint);
 
     const size_t width = static_cast<size_t>(safeData.resultSize.width());
+
+    visitValues([&](const auto &values){
+        int xpos, ypos;
+        for (size_t abs = startPoint, rel = 0; abs < endPoint; ++abs, ++rel) {
+            xpos = static_cast<int>(rel*width / (plotPointsQuan-1));
+            ypos = calcYPos(values[abs]);
+
+            plotPoints.emplace_back(xpos, ypos);
+        }
+    });
+
+    return plotPoints;
+}
+
+int RenderThread::calcYPos(double value) const
+{
     const int height = safeData.resultSize.height();
     const double k = height / (maxValue-minValue);
     const double b = height * minValue / (minValue-maxValue);
 
-    auto &points = plotFileData.points;
-    int xpos, ypos;
-    for (size_t abs = startPoint, rel = 0; abs < endPoint; ++abs, ++rel) {
-        xpos = static_cast<int>(rel*width / (plotPointsQuan-1));
-        ypos = static_cast<int>(k * points[abs].value + b);
+    return static_cast<int>(k * value + b);
+}
+
+QPixmap RenderThread::drawPixmap()
+{
+    size_t width = static_cast<size_t>(safeData.resultSize.width());
+    QPainterPath path;
+
+    if (isDrawnByColumns()) {
+        if (safeData.densityMode)
+            return drawDensity();
+        path = drawPointsByVertLines(0, width);
+    } else {
+        std::vector<QPoint> plotPoints = calcPlottedPoints();
+        if (plotPoints.empty())
+            return QPixmap();
 
-        plotPoints.emplace_back(xpos, ypos);
+        if (width >= plotPoints.size())
+            path = drawAllPoints(plotPoints);
+        else
+            path = drawPointsByMeanValue(plotPoints, width);
     }
 
-    return plotPoints;
+    QPixmap pix(safeData.resultSize.width(), safeData.resultSize.height());
+    pix.fill(Qt::white);
+    drawPath(pix, path);
+
+    return pix;
 }
 
-QPixmap RenderThread::drawPixmap(const std::vector<QPoint> &plotPoints)
+bool RenderThread::canScrollLastFrame() const
 {
-    QPixmap pix(safeData.resultSize.width(), safeData.resultSize.height());
-    size_t width = static_cast<size_t>(safeData.resultSize.width());
+    // Яркость карты плотности нормируется по всему кадру, поэтому её нельзя дорисовывать частями
+    if (lastFrame.isNull() || !isDrawnByColumns() || safeData.densityMode)
+        return false;
+
+    // После выключения режима плотности последний кадр остается картой плотности
+    if (lastFrameSize != safeData.resultSize || lastFramePoints != displayedPoints || lastFrameDensityMode)
+        return false;
+
+    return std::abs(columnsShift) < safeData.resultSize.width();
+}
+
+QPixmap RenderThread::scrollLastFrame()
+{
+    QPixmap pix = lastFrame;
+    if (columnsShift == 0)
+        return pix;
+
+    const int width = safeData.resultSize.width();
+    const int shift = static_cast<int>(columnsShift);
+    const int from = shift > 0 ? 0 : width + shift;
+    const int to   = shift > 0 ? shift : width;
+
+    pix.scroll(shift, 0, pix.rect());
 
     QPainter painter(&pix);
-    painter.fillRect(pix.rect(), Qt::white);
+    painter.fillRect(from, 0, to - from, pix.height(), Qt::white);
+    painter.end();
 
-    QPainterPath path;
+    drawPath(pix, drawPointsByVertLines(static_cast<size_t>(from), static_cast<size_t>(to)));
 
-    if (width >= plotPoints.size()) {
-        path = drawAllPoints(plotPoints);
-    } else if (width < plotPoints.size() && 2*width > plotPoints.size()) {
-        path = drawPointsByMeanValue(plotPoints, width);
-    } else {
-        path = drawPointsByVertLines(plotPoints, width);
-    }
+    return pix;
+}
+
+void RenderThread::drawPath(QPixmap &pix, const QPainterPath &path)
+{
+    frameMemory += pixmapBytes(pix.size()) + pathBytes(path);
 
+    QPainter painter(&pix);
     painter.setPen(Qt::SolidLine);
     painter.setBrush(Qt::NoBrush);
     painter.drawPath(path);
-
-    return pix;
 }
 
 QPainterPath RenderThread::drawAllPoints(const std::vector<QPoint> &plotPoints)
@@ -261,26 +694,81 @@ QPainterPath RenderThread::drawPointsByMeanValue(const std::vector<QPoint> &plot
     return path;
 }
 
-QPainterPath RenderThread::drawPointsByVertLines(const std::vector<QPoint> &plotPoints, size_t width)
+QPainterPath RenderThread::drawPointsByVertLines(size_t fromColumn, size_t toColumn)
 {
     QPainterPath path;
 
-    ptrdiff_t pointPerPix = static_cast<ptrdiff_t>(plotPoints.size() / width);
-    ptrdiff_t start, end;
-    double min, max;
+    visitValues([&](const auto &values){
+        double min, max;
+        for (size_t i = fromColumn; i < toColumn; ++i) {
+            if (frameCancellable && (i - fromColumn) % CancelCheckColumns == 0 && isRestartRequested()) {
+                frameCancelled = true;
+                return;
+            }
 
-    for (size_t i = 0; i < width; ++i) {
-        start = static_cast<ptrdiff_t>(i*plotPoints.size() / width);
-        end   = start + pointPerPix;
+            findMinMax(values, columnBegin(firstColumn + i), columnBegin(firstColumn + i + 1), min, max);
+
+            path.moveTo(i, calcYPos(min));
+            path.lineTo(i, calcYPos(max));
+        }
+    });
+
+    return path;
+}
+
+QPixmap RenderThread::drawDensity()
+{
+    // Виджет графика может быть сжат до нулевого размера
+    if (safeData.resultSize.isEmpty())
+        return QPixmap();
+
+    const auto width  = static_cast<size_t>(safeData.resultSize.width());
+    const auto height = static_cast<size_t>(safeData.resultSize.height());
+
+    // Столбцы независимы, поэтому каждый поток заполняет только свою часть гистограммы (по столбцам)
+    std::vector<quint32> hits(width * height, 0);
+    std::vector<size_t> columns(width);
+    std::iota(columns.begin(), columns.end(), 0);
+    QtConcurrent::blockingMap(columns, [this, &hits](size_t column){ countColumnHits(column, hits); });
+    if (frameCancelled)
+        return QPixmap();
+
+    // Если в кадре нет ни одного попадания, все пиксели остаются белыми (без деления 0/0)
+    const quint32 maxHits = std::max<quint32>(*std::max_element(hits.cbegin(), hits.cend()), 1);
+    const double logMaxHits = std::log1p(static_cast<double>(maxHits));
+
+    QImage image(static_cast<int>(width), static_cast<int>(height), QImage::Format_RGB32);
+    // Гистограмма, номера столбцов, изображение и полученный из него QPixmap
+    frameMemory += hits.capacity() * sizeof(quint32) + columns.capacity() * sizeof(size_t)
+            + 2 * pixmapBytes(safeData.resultSize);
+    for (size_t y = 0; y < height; ++y) {
+        auto line = reinterpret_cast<QRgb *>(image.scanLine(static_cast<int>(y)));
+        for (size_t x = 0; x < width; ++x) {
+            auto intensity = std::log1p(static_cast<double>(hits[x*height + y])) / logMaxHits;
+            auto gray = 255 - static_cast<int>(255 * intensity);
+            line[x] = qRgb(gray, gray, gray);
+        }
+    }
 
-        auto minmax = std::minmax_element(plotPoints.cbegin()+start, plotPoints.cbegin()+end,
-                                          [](const QPoint &a, const QPoint &b){ return a.y() < b.y(); });
-        min = minmax.first->y();
-        max = minmax.second->y();
+    return QPixmap::fromImage(image);
+}
+
+void RenderThread::countColumnHits(size_t column, std::vector<quint32> &hits)
+{
+    const auto height = static_cast<size_t>(safeData.resultSize.height());
+    const auto maxYPos = static_cast<int>(height) - 1;
+    auto columnHits = hits.begin() + static_cast<ptrdiff_t>(column * height);
 
-        path.moveTo(i, min);
-        path.lineTo(i, max);
+    if (frameCancellable && (frameCancelled || isRestartRequested())) {
+        frameCancelled = true;
+        return;
     }
 
-    return path;
+    const auto end = columnBegin(firstColumn + column + 1);
+    visitValues([&](const auto &values){
+        for (size_t i = columnBegin(firstColumn + column); i < end; ++i) {
+            int ypos = std::min(std::max(calcYPos(values[i]), 0), maxYPos);
+            ++columnHits[ypos];
+        }
+    });
 }
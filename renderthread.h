@@ -7,51 +7,106 @@
 #include <QWaitCondition>
 #include <vector>
 #include <atomic>
+#include <memory>
 #include <QPoint>
 #include <QPainter>
+#include <QTimer>
 
 #include "dataloader.h"
+#include "livebuffer.h"
+#include "rangestatistics.h"
 
 /*
  * Класс для вывода графика на QPixmap
  *
  * Функционал
- *  1. Принимает данные для отрисовки (setPlotFileData());
+ *  1. Принимает данные для отрисовки (setPlotFileData()): точки текстового файла (в том числе сжатые)
+ *     или отсчеты бинарного файла, которые обрабатываются в исходном типе (visitValues());
  *  2. По сигналу render() принимает данные, с информацией о том, какую часть графика отрисовавывать,
  *     и запускает отрисову в отдельном потоке;
  *  3. Для потокобезопасности используются два контейнера данных exchData и safeData;
- *  4. Данные (exchData, safeData, abort и restart), которые могут изменять разные потоки, защищены мьютексом.
+ *  4. Данные (exchData, safeData, abort и restart), которые могут изменять разные потоки, защищены мьютексом;
+ *  5. При сдвиге графика без изменения масштаба и размера предыдущий кадр сдвигается, а заново
+ *     отрисовываются только открывшиеся столбцы (scrollLastFrame());
+ *  6. В режиме плотности (setDensityMode()) каждый столбец вместо линии min-max отображается
+ *     гистограммой попаданий точек в пиксели с логарифмической шкалой яркости (drawDensity());
+ *  7. В потоковом режиме (setLiveBuffer()) не чаще frameRate раз в секунду копирует содержимое
+ *     LiveBuffer и отображает его целиком, запросы сдвига и масштаба при этом не учитываются;
+ *  8. Для больших диапазонов сначала выводит грубый кадр по уровням минимумов и максимумов
+ *     (summaryLevels), затем точный; отрисовка точного кадра прерывается новым запросом;
+ *  9. После точного кадра отправляет статистику видимого диапазона (statisticsUpdated()), если при
+ *     загрузке построен RangeStatistics;
+ * 10. Учитывает память данных файла, уровней summaryLevels, сохраненного кадра и временных буферов
+ *     отрисовки кадра (memoryUsage()).
  */
 class RenderThread : public QThread
 {
     Q_OBJECT
 
 public:
+    // Память, занимаемая данными и буферами отрисовки, байт
+    struct MemoryUsage {
+        DataLoader::MemoryUsage fileData;
+        size_t summary = 0;
+        size_t lastFrame = 0;
+        size_t frame = 0;       // временные буферы последнего кадра
+        size_t peakFrame = 0;   // наибольшее значение frame с момента загрузки
+    };
+
     RenderThread(QObject *parent = nullptr);
     ~RenderThread() override;
 
-    void setPlotFileData(DataLoader::FileData &plotFileData);
+    void setPlotFileData(std::shared_ptr<DataLoader::FileData> plotFileData);
+    void setLiveBuffer(LiveBuffer *buffer, int frameRate);
+
+    std::shared_ptr<const DataLoader::FileData> fileData() const { return plotFileData; }
+    void shownRange(size_t &start, size_t &end);
+    MemoryUsage memoryUsage();
 
 public slots:
     void render(int pixmapOffset, double scaleFactor, QSize resultSize);
+    void setDensityMode(bool enabled);
 
 signals:
     void scaleMinMaxUpdated(double min, double max);
     void plotRendered(const QPixmap &plot, double settedScaleFactor, size_t shownPoints);
+    void requestServed(quint64 requestNumber, bool exact);   // exact == false для грубого кадра
+    void statisticsUpdated(const RangeStatistics::Result &statistics);
 
 protected:
     void run() override;
 
+private slots:
+    void requestLiveFrame();
+
 private:
     void stopThread();
+    void restartRendering();
     void setupPlotData();
-    void findMinMaxValues();
+    void buildSummary();
+    template<typename Visitor>
+    void visitValues(Visitor visitor) const;
+    bool updateLiveData();
+    void renderFrame();
+    void emitFrame(const QPixmap &plot, bool exact);
+    void emitStatistics();
+    void updateMemoryUsage();
+    void findRangeMinMax(size_t start, size_t end, double &min, double &max);
+    bool isRestartRequested();
     std::vector<QPoint> calcPlottedPoints();
-
-    QPixmap drawPixmap(const std::vector<QPoint> &plotPoints);
+    int calcYPos(double value) const;
+
+    QPixmap drawPixmap();
+    QPixmap scrollLastFrame();
+    QPixmap drawCoarsePixmap();
+    bool isCoarseFrameNeeded() const;
+    bool canScrollLastFrame() const;
+    void drawPath(QPixmap &pix, const QPainterPath &path);
     QPainterPath drawAllPoints(const std::vector<QPoint> &plotPoints);
     QPainterPath drawPointsByMeanValue(const std::vector<QPoint> &plotPoints, size_t width);
-    QPainterPath drawPointsByVertLines(const std::vector<QPoint> &plotPoints, size_t width);
+    QPainterPath drawPointsByVertLines(size_t fromColumn, size_t toColumn);
+    QPixmap drawDensity();
+    void countColumnHits(size_t column, std::vector<quint32> &hits);
 
     int calcPointsOffset(size_t displayedPoints);
     int convertToSigned(size_t displayedPoints);
@@ -59,6 +114,10 @@ private:
     void calcStartPoint(size_t displayedPoints, int pointsOffset);
     void calcEndPoint(size_t displayedPoints);
 
+    bool isDrawnByColumns() const;
+    void calcFirstColumn();
+    size_t columnBegin(size_t column) const;
+
     QMutex mutex;
     QWaitCondition condition;
     bool abort = false;
@@ -68,6 +127,8 @@ private:
         int pixmapOffset;
         double scaleFactor;
         QSize resultSize;
+        bool densityMode = false;
+        quint64 requestNumber = 0;
     };
 
     ExchData exchData;
@@ -75,13 +136,45 @@ private:
 
     size_t startPoint = 0;
     size_t endPoint = 0;
+    size_t shownStart = 0;
+    size_t shownEnd = 0;
+    size_t displayedPoints = 0;
+
+    // Сетка столбцов в режиме вертикальных линий: столбец N содержит точки
+    // [N*displayedPoints/width, (N+1)*displayedPoints/width), поэтому сдвиг кадра на целое
+    // число столбцов не меняет содержимое уже отрисованных столбцов
+    size_t firstColumn = 0;
+    ptrdiff_t columnsShift = 0;
+
+    QPixmap lastFrame;
+    QSize lastFrameSize;
+    size_t lastFramePoints = 0;
+    bool lastFrameDensityMode = false;
 
     size_t pointsQuan = 0;
     size_t minShownPoints = 2;
 
-    DataLoader::FileData plotFileData;
+    std::shared_ptr<DataLoader::FileData> plotFileData = std::make_shared<DataLoader::FileData>();
     double minValue = 0.0;
     double maxValue = 0.0;
+
+    struct MinMax {
+        double min;
+        double max;
+    };
+
+    std::vector<std::vector<MinMax>> summaryLevels;
+    std::atomic<bool> frameCancelled{false};   // устанавливается и из потоков countColumnHits()
+    bool frameCancellable = false;
+
+    MemoryUsage memory;
+    size_t frameMemory = 0;
+
+    LiveBuffer *liveBuffer = nullptr;
+    quint64 liveReceivedPoints = 0;
+    QTimer liveTimer;
 };
 
+Q_DECLARE_METATYPE(RangeStatistics::Result)
+
 #endif // RENDERTHREAD_H